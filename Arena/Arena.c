@@ -0,0 +1,100 @@
+#include "Arena.h"
+
+static ArenaBlock* _newBlock(size_t size) {
+    Stats_countAllocations(1);
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + size + ARENA_DEFAULT_ALIGNMENT);
+    if (!block) {
+        fprintf(stderr, "Arena: failed to allocate %zu byte block.\n", size);
+        return NULL;
+    }
+
+    // data starts on an ARENA_DEFAULT_ALIGNMENT boundary
+    uintptr_t start = (uintptr_t)(block + 1);
+    start = (start + ARENA_DEFAULT_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_DEFAULT_ALIGNMENT - 1);
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    block->data = (unsigned char*)start;
+
+    return block;
+}
+
+// Offset of the next `alignment`-aligned address at or after block->used
+static inline size_t _alignedOffset(const ArenaBlock* block, size_t alignment) {
+    uintptr_t base = (uintptr_t)block->data;
+    uintptr_t next = (base + block->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+    return (size_t)(next - base);
+}
+
+void Arena_init(Arena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocated = 0;
+}
+
+void Arena_release(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head = NULL;
+    arena->allocated = 0;
+}
+
+void Arena_reset(Arena* arena) {
+    arena->allocated = 0;
+    if (!arena->head) return;
+
+    if (!arena->head->next) {
+        arena->head->used = 0;
+        return;
+    }
+
+    // the last round needed several blocks: replace them with one that fits it all
+    size_t total = 0;
+    for (ArenaBlock* block = arena->head; block; block = block->next)
+        total += block->size;
+
+    Arena_release(arena);
+    arena->head = _newBlock(total);
+}
+
+void* Arena_alloc(Arena* arena, size_t size, size_t alignment) {
+    if (alignment == 0) alignment = 1;
+
+    ArenaBlock* block = arena->head;
+    if (block) {
+        size_t offset = _alignedOffset(block, alignment);
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            arena->allocated += size;
+            return block->data + offset;
+        }
+    }
+
+    // blocks are aligned to ARENA_DEFAULT_ALIGNMENT, larger alignments need slack
+    size_t needed = size + (alignment > ARENA_DEFAULT_ALIGNMENT ? alignment : 0);
+    ArenaBlock* grown = _newBlock(needed > arena->block_size ? needed : arena->block_size);
+    if (!grown) return NULL;
+
+    grown->next = arena->head;
+    arena->head = grown;
+
+    size_t offset = _alignedOffset(grown, alignment);
+    grown->used = offset + size;
+    arena->allocated += size;
+
+    return grown->data + offset;
+}
+
+void* Arena_calloc(Arena* arena, size_t size, size_t alignment) {
+    void* ptr = Arena_alloc(arena, size, alignment);
+    if (ptr) memset(ptr, 0, size);
+
+    return ptr;
+}
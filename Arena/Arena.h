@@ -0,0 +1,46 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../Stats/Stats.h"
+
+#define ARENA_DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+// Cache line alignment, also enough for any SIMD load
+#define ARENA_DEFAULT_ALIGNMENT  64
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    unsigned char* data;
+} ArenaBlock;
+
+// Bump allocator for per-render scratch memory.
+// Allocations are never freed one by one: Arena_reset drops all of them at once
+// and folds the blocks into a single one big enough for the whole previous
+// round, so a repeated workload settles on one block and stops allocating.
+typedef struct Arena {
+    ArenaBlock* head;       // block currently bumped into, older blocks follow
+    size_t block_size;      // minimum size of a new block
+    size_t allocated;       // bytes handed out since the last reset
+} Arena;
+
+void Arena_init(Arena* arena, size_t block_size);
+
+// Frees every block
+void Arena_release(Arena* arena);
+
+// Invalidates every allocation, keeping (and coalescing) the memory
+void Arena_reset(Arena* arena);
+
+// `alignment` must be a power of two; returns NULL when out of memory
+void* Arena_alloc(Arena* arena, size_t size, size_t alignment);
+void* Arena_calloc(Arena* arena, size_t size, size_t alignment);
+
+#endif // ARENA_H
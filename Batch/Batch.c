@@ -0,0 +1,273 @@
+#include "Batch.h"
+
+typedef struct BatchJob {
+    char name[NAME_MAX + 1];
+    unsigned char* input;
+    size_t input_length;
+    char* output;
+    size_t output_length;
+} BatchJob;
+
+typedef struct Batch {
+    const ASCIIGenConfig* config;
+    DIR* input;
+    int output_fd;
+
+    Queue loaded;               // reader -> workers
+    Queue rendered;             // workers -> writer
+    int running_workers;        // the last one to finish closes `rendered`
+    pthread_mutex_t lock;
+
+    size_t total;               // written by the reader before `loaded` closes
+} Batch;
+
+typedef struct BatchWorker {
+    Batch* batch;
+    pthread_t thread;
+    GeneratorContext* ctx;
+    ASCIIGenConfig config;      // the batch config with private stats
+    RenderStats stats;          // merged into the batch stats after the join
+} BatchWorker;
+
+static inline const char* _extension(OutputFormat format) {
+    switch (format) {
+        case FORMAT_HTML: return ".html";
+        case FORMAT_SVG:  return ".svg";
+        case FORMAT_PNG:  return ".png";
+        default:          return ".txt";
+    }
+}
+
+static inline void _freeJob(BatchJob* job) {
+    free(job->input);
+    free(job->output);
+    free(job);
+}
+
+// Reads a whole file; the kernel is told up front so it can read ahead
+static unsigned char* _readFile(int dir_fd, const char* name, size_t* length) {
+    int fd = openat(dir_fd, name, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+    size_t size = (size_t)st.st_size;
+    unsigned char* bytes = malloc(size);
+    size_t got = 0;
+
+    while (bytes && got < size) {
+        ssize_t n = read(fd, bytes + got, size - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+
+    if (!bytes || got != size) {
+        free(bytes);
+        return NULL;
+    }
+
+    *length = size;
+    return bytes;
+}
+
+static bool _writeFile(int dir_fd, const char* name, const char* bytes, size_t length) {
+    int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    while (length > 0) {
+        ssize_t put = write(fd, bytes, length);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) break;
+        bytes += put;
+        length -= (size_t)put;
+    }
+
+    return close(fd) == 0 && length == 0;
+}
+
+static void* _readerMain(void* arg) {
+    Batch* batch = arg;
+    int dir_fd = dirfd(batch->input);
+
+    struct dirent* ent;
+    while ((ent = readdir(batch->input)) != NULL) {
+        if (ent->d_name[0] == '.') continue;
+
+        BatchJob* job = calloc(1, sizeof(BatchJob));
+        if (!job) break;
+
+        snprintf(job->name, sizeof(job->name), "%s", ent->d_name);
+        job->input = _readFile(dir_fd, job->name, &job->input_length);
+        if (!job->input) {
+            // directories and the like are skipped silently
+            free(job);
+            continue;
+        }
+
+        batch->total++;
+        if (!Queue_push(&batch->loaded, job)) {
+            _freeJob(job);
+            break;
+        }
+    }
+
+    Queue_close(&batch->loaded);
+    return NULL;
+}
+
+static void* _workerMain(void* arg) {
+    BatchWorker* worker = arg;
+    Batch* batch = worker->batch;
+
+    RenderStats* stats = worker->config.stats;
+    StatsTimer timer = { 0 };
+
+    BatchJob* job;
+    while ((job = Queue_pop(&batch->loaded)) != NULL) {
+        Stats_begin(stats, &timer);
+        Image* img = Image_loadFromMemoryAs(job->input, job->input_length, worker->config.layout);
+        if (img) Stats_end(stats, &timer, STAGE_DECODE, img->size);
+
+        free(job->input);
+        job->input = NULL;
+
+        if (img) {
+            job->output = Generator_generateASCIIToMemory(worker->ctx, img, &job->output_length, &worker->config);
+            Image_free(img);
+            free(img);
+        }
+
+        Queue_push(&batch->rendered, job);
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    bool last = --batch->running_workers == 0;
+    pthread_mutex_unlock(&batch->lock);
+
+    if (last) Queue_close(&batch->rendered);
+    return NULL;
+}
+
+// Runs on the calling thread; returns the number of outputs stored
+static size_t _writeOutputs(Batch* batch) {
+    const char* extension = _extension(batch->config->output_format);
+    size_t written = 0;
+
+    BatchJob* job;
+    while ((job = Queue_pop(&batch->rendered)) != NULL) {
+        char name[NAME_MAX + 1];
+        char* dot = strrchr(job->name, '.');
+        int stem = dot ? (int)(dot - job->name) : (int)strlen(job->name);
+        snprintf(name, sizeof(name), "%.*s%s", stem, job->name, extension);
+
+        if (!job->output) {
+            fprintf(stderr, "Batch: failed to render %s.\n", job->name);
+        } else if (!_writeFile(batch->output_fd, name, job->output, job->output_length)) {
+            fprintf(stderr, "Batch: failed to write %s.\n", name);
+        } else {
+            written++;
+        }
+
+        _freeJob(job);
+    }
+
+    return written;
+}
+
+bool Batch_run(const BatchOptions* options, const ASCIIGenConfig* config) {
+    if (!options || !options->input_dir || !options->output_dir || !config) return false;
+
+    int threads = options->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > BATCH_MAX_THREADS) threads = BATCH_MAX_THREADS;
+
+    size_t depth = options->queue_depth > 0 ? (size_t)options->queue_depth : BATCH_DEFAULT_DEPTH;
+
+    Batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.config = config;
+
+    batch.input = opendir(options->input_dir);
+    if (!batch.input) {
+        fprintf(stderr, "Batch: cannot open directory %s.\n", options->input_dir);
+        return false;
+    }
+
+    if (mkdir(options->output_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Batch: cannot create directory %s.\n", options->output_dir);
+        closedir(batch.input);
+        return false;
+    }
+    batch.output_fd = open(options->output_dir, O_RDONLY | O_DIRECTORY);
+    if (batch.output_fd < 0) {
+        fprintf(stderr, "Batch: cannot open directory %s.\n", options->output_dir);
+        closedir(batch.input);
+        return false;
+    }
+
+    if (!Queue_init(&batch.loaded, depth) || !Queue_init(&batch.rendered, depth)) {
+        close(batch.output_fd);
+        closedir(batch.input);
+        return false;
+    }
+    pthread_mutex_init(&batch.lock, NULL);
+
+    BatchWorker workers[BATCH_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    int started = 0;
+
+    pthread_mutex_lock(&batch.lock);
+    for (; started < threads; started++) {
+        BatchWorker* worker = &workers[started];
+        worker->batch = &batch;
+        worker->config = *config;
+        worker->config.stats = config->stats ? &worker->stats : NULL;
+        worker->ctx = GeneratorContext_create();
+        if (!worker->ctx || pthread_create(&worker->thread, NULL, _workerMain, worker) != 0) {
+            GeneratorContext_free(worker->ctx);
+            break;
+        }
+        batch.running_workers++;
+    }
+    pthread_mutex_unlock(&batch.lock);
+
+    pthread_t reader;
+    bool reading = started > 0 && pthread_create(&reader, NULL, _readerMain, &batch) == 0;
+    if (!reading) {
+        fprintf(stderr, "Batch: failed to start threads.\n");
+        Queue_close(&batch.loaded);
+        if (started == 0) Queue_close(&batch.rendered);
+    }
+
+    size_t written = _writeOutputs(&batch);
+
+    if (reading) pthread_join(reader, NULL);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        GeneratorContext_free(workers[i].ctx);
+        Stats_merge(config->stats, &workers[i].stats);
+    }
+
+    pthread_mutex_destroy(&batch.lock);
+    Queue_destroy(&batch.rendered);
+    Queue_destroy(&batch.loaded);
+    close(batch.output_fd);
+    closedir(batch.input);
+
+    if (reading)
+        fprintf(stderr, "Batch: rendered %zu of %zu images.\n", written, batch.total);
+
+    return reading && written == batch.total;
+}
@@ -0,0 +1,39 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../IO/Queue.h"
+#include "../Generator/Generator.h"
+
+#define BATCH_MAX_THREADS     64
+#define BATCH_DEFAULT_DEPTH   16
+
+typedef struct BatchOptions {
+    const char* input_dir;
+    const char* output_dir;     // created if missing
+    int threads;                // render workers, 0 for one per online CPU
+    int queue_depth;            // images buffered between stages, 0 for the default
+} BatchOptions;
+
+// Renders every regular file in `input_dir` to `output_dir`, naming each
+// output after its input with the extension of `config->output_format`.
+// A reader thread loads files ahead of the render workers and the calling
+// thread stores their results, so disk I/O overlaps the CPU work; the bounded
+// queues between the stages cap how many images are held in memory at once.
+// Stage timings of every worker are added to `config->stats` when it is set.
+// Returns false if the directories cannot be used or any image failed.
+bool Batch_run(const BatchOptions* options, const ASCIIGenConfig* config);
+
+#endif // BATCH_H
@@ -0,0 +1,174 @@
+#include "Corpus.h"
+
+#define PHOTO_SHAPES 24
+
+static const char* PATTERN_NAMES[PATTERN_COUNT] = {
+    "gradient",
+    "noise",
+    "photo"
+};
+
+// splitmix64: tiny, fast and identical on every platform
+static inline uint64_t _next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline float _unit(uint64_t* state) {
+    return (float)(_next(state) >> 40) / (float)(1 << 24);
+}
+
+static inline uint8_t _clampByte(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 255.0f) return 255;
+    return (uint8_t)(v + 0.5f);
+}
+
+const char* Corpus_patternName(CorpusPattern pattern) {
+    return pattern < PATTERN_COUNT ? PATTERN_NAMES[pattern] : "unknown";
+}
+
+CorpusPattern Corpus_patternFromName(const char* name) {
+    for (int i = 0; i < PATTERN_COUNT; i++) {
+        if (strcmp(name, PATTERN_NAMES[i]) == 0)
+            return (CorpusPattern)i;
+    }
+    return PATTERN_COUNT;
+}
+
+static void _fillGradient(Image* img) {
+    float sx = 255.0f / (float)(img->width > 1 ? img->width - 1 : 1);
+    float sy = 255.0f / (float)(img->height > 1 ? img->height - 1 : 1);
+
+    for (int y = 0; y < img->height; y++) {
+        uint8_t* row = Image_row(img, y);
+        for (int x = 0; x < img->width; x++) {
+            row[x * 3]     = _clampByte(x * sx);
+            row[x * 3 + 1] = _clampByte(y * sy);
+            row[x * 3 + 2] = _clampByte(255.0f - (x * sx + y * sy) * 0.5f);
+        }
+    }
+}
+
+// The same byte stream as one unpadded buffer: eight bytes per draw, one
+// draw per byte for the last few
+static void _fillNoise(Image* img, uint64_t seed) {
+    uint64_t state = seed;
+    size_t row_bytes = (size_t)img->width * 3;
+    size_t size = row_bytes * img->height;
+
+    uint8_t bits[8];
+    size_t i = 0, used = 0, drawn = 0;
+    for (int y = 0; y < img->height; y++) {
+        uint8_t* row = Image_row(img, y);
+        for (size_t x = 0; x < row_bytes; x++, i++) {
+            if (used == drawn) {
+                uint64_t next = _next(&state);
+                memcpy(bits, &next, 8);
+                used = 0;
+                drawn = (size - i >= 8) ? 8 : 1;
+            }
+            row[x] = bits[used++];
+        }
+    }
+}
+
+typedef struct PhotoShape {
+    float cx, cy, radius;
+    bool disc;
+    float color[3];
+} PhotoShape;
+
+static void _fillPhoto(Image* img, uint64_t seed) {
+    uint64_t state = seed;
+    float w = (float)img->width, h = (float)img->height;
+
+    // low-frequency "lighting" from a few sinusoids
+    float fx[3], fy[3], phase[3];
+    for (int c = 0; c < 3; c++) {
+        fx[c] = (1.0f + _unit(&state) * 2.0f) * 6.2831853f / w;
+        fy[c] = (1.0f + _unit(&state) * 2.0f) * 6.2831853f / h;
+        phase[c] = _unit(&state) * 6.2831853f;
+    }
+
+    // sizes are relative, so every resolution shows the same scene
+    PhotoShape shapes[PHOTO_SHAPES];
+    for (int i = 0; i < PHOTO_SHAPES; i++) {
+        shapes[i].cx = _unit(&state) * w;
+        shapes[i].cy = _unit(&state) * h;
+        shapes[i].radius = (0.03f + _unit(&state) * 0.12f) * (w < h ? w : h);
+        shapes[i].disc = _unit(&state) < 0.5f;
+        for (int c = 0; c < 3; c++)
+            shapes[i].color[c] = _unit(&state) * 255.0f;
+    }
+
+    // the lighting is separable, so the column terms are computed once
+    float* columns = malloc(sizeof(float) * 3 * img->width);
+    if (!columns) return;
+    for (int x = 0; x < img->width; x++) {
+        for (int c = 0; c < 3; c++)
+            columns[x * 3 + c] = 70.0f * sinf(x * fx[c] + phase[c]);
+    }
+
+    for (int y = 0; y < img->height; y++) {
+        uint8_t* row = Image_row(img, y);
+
+        float light[3];
+        for (int c = 0; c < 3; c++)
+            light[c] = cosf(y * fy[c]);
+
+        // only shapes crossing this row are tested per pixel
+        int hits[PHOTO_SHAPES], hit_count = 0;
+        for (int i = 0; i < PHOTO_SHAPES; i++) {
+            if (fabsf((float)y - shapes[i].cy) <= shapes[i].radius)
+                hits[hit_count++] = i;
+        }
+
+        for (int x = 0; x < img->width; x++) {
+            float px[3];
+            for (int c = 0; c < 3; c++)
+                px[c] = 128.0f + columns[x * 3 + c] * light[c];
+
+            // later shapes are drawn on top
+            for (int h = 0; h < hit_count; h++) {
+                const PhotoShape* shape = &shapes[hits[h]];
+                float dx = (float)x - shape->cx;
+                float dy = (float)y - shape->cy;
+                float r = shape->radius;
+                bool inside = shape->disc ? dx * dx + dy * dy <= r * r
+                                          : fabsf(dx) <= r && fabsf(dy) <= r * 0.6f;
+                if (inside) {
+                    // soft shading toward the shape's lower right
+                    float shade = 0.75f + 0.25f * (dx + dy) / (2.0f * r);
+                    for (int c = 0; c < 3; c++)
+                        px[c] = shape->color[c] * shade;
+                }
+            }
+
+            // film grain
+            uint64_t grain = _next(&state);
+            for (int c = 0; c < 3; c++)
+                row[x * 3 + c] = _clampByte(px[c] + (float)((grain >> (c * 8)) & 0x1F) - 16.0f);
+        }
+    }
+
+    free(columns);
+}
+
+Image* Corpus_generate(CorpusPattern pattern, int width, int height, uint64_t seed) {
+    if (pattern >= PATTERN_COUNT || width <= 0 || height <= 0) return NULL;
+
+    Image* img = Image_create(width, height, 3, false);
+    if (!img) return NULL;
+
+    switch (pattern) {
+        case PATTERN_GRADIENT: _fillGradient(img); break;
+        case PATTERN_NOISE:    _fillNoise(img, seed); break;
+        case PATTERN_PHOTO:    _fillPhoto(img, seed); break;
+        default: break;
+    }
+
+    return img;
+}
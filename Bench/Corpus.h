@@ -0,0 +1,32 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "../Image/Image.h"
+
+// Synthetic benchmark inputs. Every pattern is a pure function of its size
+// and seed, so runs on different machines and builds see identical pixels.
+typedef enum CorpusPattern {
+    PATTERN_GRADIENT,   // smooth diagonal RGB ramps, best case for caches and branches
+    PATTERN_NOISE,      // uniform white noise, worst case for dithering and edges
+    PATTERN_PHOTO,      // soft shading, hard-edged shapes and grain, like a photograph
+    PATTERN_COUNT
+} CorpusPattern;
+
+#define CORPUS_DEFAULT_SEED 0x67656E53434949ull
+
+const char* Corpus_patternName(CorpusPattern pattern);
+
+// Parses a name from Corpus_patternName; returns PATTERN_COUNT when unknown
+CorpusPattern Corpus_patternFromName(const char* name);
+
+// Creates a width x height RGB image; the caller frees it with Image_free
+Image* Corpus_generate(CorpusPattern pattern, int width, int height, uint64_t seed);
+
+#endif // CORPUS_H
@@ -0,0 +1,311 @@
+#include "Cache.h"
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#define XXH_PRIME1 0x9E3779B185EBCA87ull
+#define XXH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME3 0x165667B19E3779F9ull
+#define XXH_PRIME4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME5 0x27D4EB2F165667C5ull
+
+#define CACHE_COPY_CHUNK (64 * 1024)
+
+typedef struct CacheEntry {
+    struct timespec last_used;
+    uint64_t size;
+    char name[40];
+} CacheEntry;
+
+static inline uint64_t _rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t _read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t _read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME2;
+    acc = _rotl(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static inline uint64_t _mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= _round(0, val);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+uint64_t Cache_hash(const void* bytes, size_t length, uint64_t seed) {
+    const unsigned char* p = bytes;
+    const unsigned char* end = p + length;
+    uint64_t h;
+
+    // four independent lanes over 32-byte stripes, then a scalar tail
+    if (length >= 32) {
+        uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = seed + XXH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME1;
+
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = _round(v1, _read64(p));
+            v2 = _round(v2, _read64(p + 8));
+            v3 = _round(v3, _read64(p + 16));
+            v4 = _round(v4, _read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = _rotl(v1, 1) + _rotl(v2, 7) + _rotl(v3, 12) + _rotl(v4, 18);
+        h = _mergeRound(h, v1);
+        h = _mergeRound(h, v2);
+        h = _mergeRound(h, v3);
+        h = _mergeRound(h, v4);
+    } else {
+        h = seed + XXH_PRIME5;
+    }
+
+    h += (uint64_t)length;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= _round(0, _read64(p));
+        h = _rotl(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)_read32(p) * XXH_PRIME1;
+        h = _rotl(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * XXH_PRIME5;
+        h = _rotl(h, 11) * XXH_PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME2;
+    h ^= h >> 29;
+    h *= XXH_PRIME3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+RenderCache* Cache_open(const char* directory, uint64_t max_bytes) {
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cache: cannot create directory %s.\n", directory);
+        return NULL;
+    }
+
+    RenderCache* cache = malloc(sizeof(RenderCache));
+    if (!cache) {
+        fprintf(stderr, "Cache: failed to allocate cache.\n");
+        return NULL;
+    }
+
+    cache->directory = strdup(directory);
+    cache->max_bytes = max_bytes > 0 ? max_bytes : CACHE_DEFAULT_MAX_BYTES;
+    if (!cache->directory) {
+        fprintf(stderr, "Cache: failed to allocate cache.\n");
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void Cache_close(RenderCache* cache) {
+    if (!cache) return;
+
+    free(cache->directory);
+    free(cache);
+}
+
+static inline void _entryPath(const RenderCache* cache, const CacheKey* key, char* path, size_t size) {
+    snprintf(path, size, "%s/%016llx%016llx" CACHE_ENTRY_SUFFIX, cache->directory,
+             (unsigned long long)key->content, (unsigned long long)key->variant);
+}
+
+static inline bool _writeAll(int fd, const unsigned char* bytes, size_t length) {
+    while (length > 0) {
+        ssize_t put = write(fd, bytes, length);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += put;
+        length -= (size_t)put;
+    }
+    return true;
+}
+
+bool Cache_copyFile(int in_fd, int out_fd) {
+#ifdef __linux__
+    // kernel-side copy; falls back to read/write for file types it refuses
+    for (;;) {
+        ssize_t sent = sendfile(out_fd, in_fd, NULL, 1 << 30);
+        if (sent == 0) return true;
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EINVAL || errno == ENOSYS) break;
+            return false;
+        }
+    }
+#endif
+
+    char buffer[CACHE_COPY_CHUNK];
+    for (;;) {
+        ssize_t got = read(in_fd, buffer, sizeof(buffer));
+        if (got == 0) return true;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        if (!_writeAll(out_fd, (const unsigned char*)buffer, (size_t)got))
+            return false;
+    }
+}
+
+int Cache_openEntry(RenderCache* cache, const CacheKey* key, uint64_t* size) {
+    char path[4096];
+    _entryPath(cache, key, path, sizeof(path));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // the mtime doubles as the LRU timestamp
+    futimens(fd, NULL);
+
+    if (size) *size = (uint64_t)st.st_size;
+    return fd;
+}
+
+bool Cache_fetch(RenderCache* cache, const CacheKey* key, int out_fd) {
+    int fd = Cache_openEntry(cache, key, NULL);
+    if (fd < 0) return false;
+
+    bool success = Cache_copyFile(fd, out_fd);
+    close(fd);
+
+    return success;
+}
+
+static int _compareEntries(const void* a, const void* b) {
+    const CacheEntry* ea = a;
+    const CacheEntry* eb = b;
+
+    if (ea->last_used.tv_sec != eb->last_used.tv_sec)
+        return (ea->last_used.tv_sec > eb->last_used.tv_sec) ? 1 : -1;
+
+    return (ea->last_used.tv_nsec > eb->last_used.tv_nsec) - (ea->last_used.tv_nsec < eb->last_used.tv_nsec);
+}
+
+static inline bool _isEntryName(const char* name) {
+    size_t len = strlen(name);
+    size_t suffix = sizeof(CACHE_ENTRY_SUFFIX) - 1;
+
+    return len == 32 + suffix && strcmp(name + 32, CACHE_ENTRY_SUFFIX) == 0;
+}
+
+static void _evict(RenderCache* cache) {
+    DIR* dir = opendir(cache->directory);
+    if (!dir) return;
+
+    CacheEntry* entries = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t total = 0;
+
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (!_isEntryName(ent->d_name)) continue;
+
+        struct stat st;
+        if (fstatat(dirfd(dir), ent->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode))
+            continue;
+
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 64;
+            CacheEntry* tmp = realloc(entries, grown * sizeof(CacheEntry));
+            if (!tmp) break;
+            entries = tmp;
+            capacity = grown;
+        }
+
+        entries[count].last_used = st.st_mtim;
+        entries[count].size = (uint64_t)st.st_size;
+        // _isEntryName already bounded the length
+        memcpy(entries[count].name, ent->d_name, strlen(ent->d_name) + 1);
+        total += entries[count].size;
+        count++;
+    }
+
+    if (total > cache->max_bytes) {
+        qsort(entries, count, sizeof(CacheEntry), _compareEntries);
+
+        for (size_t i = 0; i < count && total > cache->max_bytes; i++) {
+            if (unlinkat(dirfd(dir), entries[i].name, 0) == 0)
+                total -= entries[i].size;
+        }
+    }
+
+    free(entries);
+    closedir(dir);
+}
+
+// Writes an entry through a temp file; exactly one of `in_fd` / `bytes` is used
+static bool _publish(RenderCache* cache, const CacheKey* key, int in_fd, const void* bytes, size_t length) {
+    char path[4096], tmp_path[4096];
+    _entryPath(cache, key, path, sizeof(path));
+    // unique per process and per call, so concurrent stores of one key do not collide
+    static unsigned long sequence = 0;
+    unsigned long id = __atomic_fetch_add(&sequence, 1, __ATOMIC_RELAXED);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp-%ld-%lu", cache->directory, (long)getpid(), id);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Cache: cannot create %s.\n", tmp_path);
+        return false;
+    }
+
+    bool success = bytes ? _writeAll(fd, bytes, length)
+                         : lseek(in_fd, 0, SEEK_SET) == 0 && Cache_copyFile(in_fd, fd);
+    if (close(fd) != 0) success = false;
+
+    // readers only ever see complete entries
+    if (!success || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        fprintf(stderr, "Cache: failed to store %s.\n", path);
+        return false;
+    }
+
+    _evict(cache);
+
+    return true;
+}
+
+bool Cache_store(RenderCache* cache, const CacheKey* key, int in_fd) {
+    return _publish(cache, key, in_fd, NULL, 0);
+}
+
+bool Cache_storeBytes(RenderCache* cache, const CacheKey* key, const void* bytes, size_t length) {
+    if (!bytes && length > 0) return false;
+
+    // an empty output still needs a non-NULL pointer to select the memory path
+    return _publish(cache, key, -1, bytes ? bytes : "", length);
+}
@@ -0,0 +1,61 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CACHE_DEFAULT_MAX_BYTES (256ull * 1024 * 1024)
+
+// Entries are named by the 32 hex digits of their key
+#define CACHE_ENTRY_SUFFIX ".out"
+
+// 128-bit key: hash of the input bytes, and hash of everything else that
+// changes the output (config, grid size) seeded with the first one
+typedef struct CacheKey {
+    uint64_t content;
+    uint64_t variant;
+} CacheKey;
+
+// Content-addressed directory of rendered outputs, bounded in size.
+// The modification time of an entry is its last use: hits touch it and
+// eviction removes the oldest entries first. Entries are published with an
+// atomic rename, so several processes may share one directory.
+typedef struct RenderCache {
+    char* directory;
+    uint64_t max_bytes;
+} RenderCache;
+
+// XXH64 of `bytes`
+uint64_t Cache_hash(const void* bytes, size_t length, uint64_t seed);
+
+// Creates `directory` if needed; `max_bytes` of 0 selects CACHE_DEFAULT_MAX_BYTES
+RenderCache* Cache_open(const char* directory, uint64_t max_bytes);
+void Cache_close(RenderCache* cache);
+
+// Copies the entry for `key` to `out_fd` (sendfile where available).
+// Returns false on a miss, leaving `out_fd` untouched.
+bool Cache_fetch(RenderCache* cache, const CacheKey* key, int out_fd);
+
+// Opens the entry for `key` for reading and marks it as recently used.
+// Returns -1 on a miss; `size` receives the entry length.
+int Cache_openEntry(RenderCache* cache, const CacheKey* key, uint64_t* size);
+
+// Stores the whole file behind `in_fd` under `key`, then evicts the least
+// recently used entries until the directory fits in max_bytes again
+bool Cache_store(RenderCache* cache, const CacheKey* key, int in_fd);
+
+// Same as Cache_store for output that is already in memory
+bool Cache_storeBytes(RenderCache* cache, const CacheKey* key, const void* bytes, size_t length);
+
+// Copies everything from the current offset of `in_fd` to `out_fd`
+bool Cache_copyFile(int in_fd, int out_fd);
+
+#endif // CACHE_H
@@ -0,0 +1,20 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+#define FONT_GLYPH_WIDTH  8
+#define FONT_GLYPH_HEIGHT 8
+
+#define FONT_FIRST_CHAR   0x20
+#define FONT_LAST_CHAR    0x7E
+#define FONT_GLYPH_COUNT  (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+
+// Returns the FONT_GLYPH_HEIGHT row bitmasks of `c` (bit 0 = leftmost pixel).
+// Characters outside printable ASCII map to '?'.
+const uint8_t* Font_getGlyph(unsigned char c);
+
+// Number of set pixels of `c`, out of FONT_GLYPH_WIDTH * FONT_GLYPH_HEIGHT
+int Font_glyphCoverage(unsigned char c);
+
+#endif // FONT_H
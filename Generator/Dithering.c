@@ -6,7 +6,7 @@ static inline float _sampleCellLuminance(Image* img, int x0, int y0, int x1, int
 
     for (int y = y0; y < y1; y++) {
         for (int x = x0; x < x1; x++) {
-            total += img->data[y * img->width + x];
+            total += Image_row(img, y)[x];
             count++;
         }
     }
@@ -17,11 +17,13 @@ static inline float _sampleCellLuminance(Image* img, int x0, int y0, int x1, int
 void Dithering_applyFloydSteinberg(Image* gray_img, 
                                    int ascii_width, int ascii_height, 
                                    float scale_x, float scale_y,
-                                   const char* char_set) {
+                                   const char* char_set,
+                                   float* scratch) {
     int len = strlen(char_set);
     if (len <= 1) return;
 
-    float* buffer = malloc(ascii_width * ascii_height * sizeof(float));
+    if (!scratch) Stats_countAllocations(1);
+    float* buffer = scratch ? scratch : malloc((size_t)ascii_width * ascii_height * sizeof(float));
     if (!buffer) {
         fprintf(stderr, "Dithering: failed to allocate buffer.\n");
         return;
@@ -85,11 +87,89 @@ void Dithering_applyFloydSteinberg(Image* gray_img,
             for (int yy = y0; yy < y1; yy++) {
                 for (int xx = x0; xx < x1; xx++) {
                     if (xx < gray_img->width && yy < gray_img->height)
-                        gray_img->data[yy * gray_img->width + xx] = q;
+                        Image_row(gray_img, yy)[xx] = q;
                 }
             }
         }
     }
 
-    free(buffer);
+    if (buffer != scratch) free(buffer);
+}
+
+static inline void _diffuseFixed(int32_t* cell, int32_t error) {
+    int32_t value = *cell + error;
+    *cell = (value < 0) ? 0 : (value > (int32_t)FIXED_WHITE) ? (int32_t)FIXED_WHITE : value;
+}
+
+void Dithering_applyFloydSteinbergFixed(Image* gray_img, const FixedGrid* grid,
+                                        const char* char_set,
+                                        int32_t* scratch) {
+    int len = strlen(char_set);
+    if (len <= 1) return;
+
+    int width = grid->columns;
+    int height = grid->rows;
+
+    if (!scratch) Stats_countAllocations(1);
+    int32_t* buffer = scratch ? scratch : malloc((size_t)width * height * sizeof(int32_t));
+    if (!buffer) {
+        fprintf(stderr, "Dithering: failed to allocate buffer.\n");
+        return;
+    }
+
+    const Kernels* kernels = Kernels_get();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int x0, y0, x1, y1;
+            FixedGrid_cell(grid, x, y, false, &x0, &y0, &x1, &y1);
+
+            int32_t mean = 0;
+            if (x1 > x0 && y1 > y0) {
+                uint64_t total = kernels->sumBlock(Image_row(gray_img, y0) + x0, gray_img->stride, x1 - x0, y1 - y0);
+                mean = (int32_t)Fixed_mean(total, FixedGrid_reciprocal(grid, x1 - x0, y1 - y0));
+            }
+            buffer[y * width + x] = mean;
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int idx = y * width + x;
+
+            int32_t old_brightness = buffer[idx];
+            int32_t new_brightness = (int32_t)Fixed_levelValue(Fixed_levelIndex((Fixed16)old_brightness, len), len);
+
+            buffer[idx] = new_brightness;
+
+            // divisions rather than shifts, so negative errors round like positive ones
+            int32_t error = old_brightness - new_brightness;
+
+            if (x + 1 < width)
+                _diffuseFixed(&buffer[idx + 1], error * 7 / 16);
+
+            if (x - 1 >= 0 && y + 1 < height)
+                _diffuseFixed(&buffer[idx + width - 1], error * 3 / 16);
+
+            if (y + 1 < height)
+                _diffuseFixed(&buffer[idx + width], error * 5 / 16);
+
+            if (x + 1 < width && y + 1 < height)
+                _diffuseFixed(&buffer[idx + width + 1], error / 16);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char q = Fixed_toByte((Fixed16)buffer[y * width + x]);
+
+            int x0, y0, x1, y1;
+            FixedGrid_cell(grid, x, y, false, &x0, &y0, &x1, &y1);
+
+            for (int yy = y0; yy < y1; yy++)
+                memset(Image_row(gray_img, yy) + x0, q, (size_t)(x1 - x0));
+        }
+    }
+
+    if (buffer != scratch) free(buffer);
 }
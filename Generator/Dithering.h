@@ -5,11 +5,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "FixedPoint.h"
 #include "../Image/Image.h"
 
+// `scratch` must hold ascii_width * ascii_height floats, or be NULL to allocate one
 void Dithering_applyFloydSteinberg(Image* gray_img,
                                    int ascii_width, int ascii_height,
                                    float scale_x, float scale_y,
-                                   const char* char_set);
+                                   const char* char_set,
+                                   float* scratch);
+
+// Integer version over the cells of `grid`: 16.16 cell means, error diffused
+// with integer weights. `scratch` must hold columns * rows int32_t, or be NULL.
+void Dithering_applyFloydSteinbergFixed(Image* gray_img, const FixedGrid* grid,
+                                        const char* char_set,
+                                        int32_t* scratch);
 
 #endif // DITHERING_H
@@ -0,0 +1,199 @@
+#include "Encoder.h"
+
+// channel levels of the 6x6x6 cube of the 256-color palette
+static const unsigned char ANSI256_LEVELS[6] = { 0, 95, 135, 175, 215, 255 };
+
+static inline void _rgbToAnsiEscape(unsigned char r, unsigned char g, unsigned char b,
+                                    ColorMode mode,
+                                    char* out_buffer, size_t buffer_size) {
+    switch (mode) {
+        case COLOR_16: {
+            int index = Kernels_ansi16Index(r, g, b);
+            snprintf(out_buffer, buffer_size, "38;5;%d", index); 
+            break;
+        }
+        case COLOR_256: {
+            int index = Kernels_ansi256Index(r, g, b);
+            snprintf(out_buffer, buffer_size, "38;5;%d", index); 
+            break;
+        }
+        case COLOR_TRUE:
+            snprintf(out_buffer, buffer_size, "38;2;%d;%d;%d", r, g, b); 
+            break;
+        default:
+            out_buffer[0] = '\0';
+    }
+}
+
+static inline void _writeANSIPayloadCell(OutputBuffer* out,
+                                         const char* glyph, size_t glyph_length,
+                                         const char* ansi_payload) {
+    Output_write(out, "\x1b[", 2);
+    Output_puts(out, ansi_payload);
+    Output_putc(out, 'm');
+    Output_write(out, glyph, glyph_length);
+    Output_write(out, "\x1b[0m", 4);
+}
+
+static inline void _writeANSICell(OutputBuffer* out,
+                                  const char* glyph, size_t glyph_length,
+                                  unsigned char r, unsigned char g, unsigned char b,
+                                  ColorMode mode) {
+    if (mode == COLOR_NONE) {
+        Output_write(out, glyph, glyph_length);
+        return;
+    }
+
+    char ansi_payload[32];
+    _rgbToAnsiEscape(r, g, b, mode, ansi_payload, sizeof(ansi_payload));
+    _writeANSIPayloadCell(out, glyph, glyph_length, ansi_payload);
+}
+
+uint32_t Encoder_quantizeColor(unsigned char r, unsigned char g, unsigned char b, ColorMode mode) {
+    switch (mode) {
+        case COLOR_16:
+            return Encoder_ansiPaletteColor(Kernels_ansi16Index(r, g, b));
+        case COLOR_256:
+            return Encoder_ansiPaletteColor(Kernels_ansi256Index(r, g, b));
+        default:
+            return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+}
+
+uint32_t Encoder_ansiPaletteColor(int index) {
+    if (index < 0 || index > 255) index = 7;
+
+    if (index < 16) {
+        const unsigned char* rgb = KERNELS_ANSI16_RGB[index];
+        return ((uint32_t)rgb[0] << 16) | ((uint32_t)rgb[1] << 8) | rgb[2];
+    }
+
+    if (index >= 232) {
+        uint32_t level = 8 + 10 * (index - 232);
+        return (level << 16) | (level << 8) | level;
+    }
+
+    index -= 16;
+    return ((uint32_t)ANSI256_LEVELS[index / 36] << 16)
+         | ((uint32_t)ANSI256_LEVELS[(index / 6) % 6] << 8)
+         | ANSI256_LEVELS[index % 6];
+}
+
+void Encoder_init(Encoder* encoder) {
+    memset(encoder, 0, sizeof(Encoder));
+}
+
+void Encoder_free(Encoder* encoder) {
+    HTML_free(&encoder->html);
+}
+
+bool Encoder_begin(Encoder* encoder, OutputBuffer* out,
+                   OutputFormat format, ColorMode color_mode,
+                   int columns, int rows) {
+    encoder->format = format;
+    encoder->color_mode = color_mode;
+    encoder->out = out;
+
+    switch (format) {
+        case FORMAT_HTML:
+            return HTML_begin(&encoder->html, out, color_mode != COLOR_NONE);
+        case FORMAT_SVG:
+            return SVG_begin(&encoder->svg, out, color_mode != COLOR_NONE, columns, rows);
+        default:
+            return true;
+    }
+}
+
+void Encoder_putCell(Encoder* encoder, const char* glyph, size_t glyph_length,
+                     unsigned char r, unsigned char g, unsigned char b) {
+    switch (encoder->format) {
+        case FORMAT_HTML:
+            HTML_putCell(&encoder->html, glyph, glyph_length, Encoder_quantizeColor(r, g, b, encoder->color_mode));
+            break;
+        case FORMAT_SVG:
+            SVG_putCell(&encoder->svg, glyph, glyph_length, Encoder_quantizeColor(r, g, b, encoder->color_mode));
+            break;
+        default:
+            _writeANSICell(encoder->out, glyph, glyph_length, r, g, b, encoder->color_mode);
+    }
+}
+
+void Encoder_putPaletteCell(Encoder* encoder, const char* glyph, size_t glyph_length, int index) {
+    switch (encoder->format) {
+        case FORMAT_HTML:
+            HTML_putCell(&encoder->html, glyph, glyph_length, Encoder_ansiPaletteColor(index));
+            break;
+        case FORMAT_SVG:
+            SVG_putCell(&encoder->svg, glyph, glyph_length, Encoder_ansiPaletteColor(index));
+            break;
+        default: {
+            char ansi_payload[16];
+            snprintf(ansi_payload, sizeof(ansi_payload), "38;5;%d", index);
+            _writeANSIPayloadCell(encoder->out, glyph, glyph_length, ansi_payload);
+        }
+    }
+}
+
+void Encoder_endRow(Encoder* encoder) {
+    switch (encoder->format) {
+        case FORMAT_HTML:
+            HTML_endRow(&encoder->html);
+            break;
+        case FORMAT_SVG:
+            SVG_endRow(&encoder->svg);
+            break;
+        default:
+            Output_putc(encoder->out, '\n');
+    }
+}
+
+bool Encoder_end(Encoder* encoder) {
+    switch (encoder->format) {
+        case FORMAT_HTML:
+            return HTML_end(&encoder->html);
+        case FORMAT_SVG:
+            return SVG_end(&encoder->svg);
+        default:
+            return !encoder->out->failed;
+    }
+}
+
+static inline size_t _ansiPayloadMaxLength(ColorMode mode) {
+    switch (mode) {
+        case COLOR_16:   return sizeof("38;5;15") - 1;
+        case COLOR_256:  return sizeof("38;5;231") - 1;
+        case COLOR_TRUE: return sizeof("38;2;255;255;255") - 1;
+        default:         return 0;
+    }
+}
+
+static inline size_t _paletteSize(ColorMode mode) {
+    switch (mode) {
+        case COLOR_16:  return 16;
+        case COLOR_256: return 256;
+        default:        return (size_t)1 << 24;
+    }
+}
+
+size_t Encoder_maxOutputSize(OutputFormat format, ColorMode color_mode,
+                             int columns, int rows, size_t max_glyph_length) {
+    if (columns <= 0 || rows <= 0)
+        return 0;
+
+    bool colored = color_mode != COLOR_NONE;
+
+    switch (format) {
+        case FORMAT_HTML:
+            return HTML_maxOutputSize(colored, (size_t)columns, (size_t)rows, max_glyph_length, _paletteSize(color_mode));
+        case FORMAT_SVG:
+            return SVG_maxOutputSize(colored, (size_t)columns, (size_t)rows, max_glyph_length);
+        case FORMAT_TEXT: {
+            size_t cell = max_glyph_length;
+            if (colored)
+                cell += 2 + _ansiPayloadMaxLength(color_mode) + 1 + 4;    // ESC[ payload m ... ESC[0m
+            return (size_t)rows * ((size_t)columns * cell + 1);
+        }
+        default:
+            return 0;
+    }
+}
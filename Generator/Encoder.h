@@ -0,0 +1,64 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "HTML.h"
+#include "Output.h"
+#include "SVG.h"
+#include "../Kernels/Kernels.h"
+
+typedef enum ColorMode {
+    COLOR_NONE,
+    COLOR_16,
+    COLOR_256,
+    COLOR_TRUE
+} ColorMode;
+
+typedef enum OutputFormat {
+    FORMAT_TEXT,    // plain text, or ANSI escapes when colored
+    FORMAT_HTML,
+    FORMAT_SVG,
+    FORMAT_PNG      // text rasterized with the embedded bitmap font
+} OutputFormat;
+
+// Turns a stream of (glyph, color) cells into the bytes of one output format
+typedef struct Encoder {
+    OutputFormat format;
+    ColorMode color_mode;
+    OutputBuffer* out;
+    HTMLWriter html;
+    SVGWriter svg;
+} Encoder;
+
+// Zeroes `encoder`; state kept between documents is released by Encoder_free
+void Encoder_init(Encoder* encoder);
+void Encoder_free(Encoder* encoder);
+
+bool Encoder_begin(Encoder* encoder, OutputBuffer* out,
+                   OutputFormat format, ColorMode color_mode,
+                   int columns, int rows);
+void Encoder_putCell(Encoder* encoder, const char* glyph, size_t glyph_length,
+                     unsigned char r, unsigned char g, unsigned char b);
+
+// Same as Encoder_putCell for a color already snapped onto the palette of a
+// COLOR_16 or COLOR_256 encoder; `index` is the entry of the 256-color palette
+void Encoder_putPaletteCell(Encoder* encoder, const char* glyph, size_t glyph_length, int index);
+void Encoder_endRow(Encoder* encoder);
+bool Encoder_end(Encoder* encoder);
+
+// Upper bound of the bytes a columns x rows grid encodes to, given the longest
+// glyph in bytes; 0 for formats that are not encoded as a byte stream (PNG)
+size_t Encoder_maxOutputSize(OutputFormat format, ColorMode color_mode,
+                             int columns, int rows, size_t max_glyph_length);
+
+// Snaps a color onto the palette of `mode` and returns it packed as 0xRRGGBB
+uint32_t Encoder_quantizeColor(unsigned char r, unsigned char g, unsigned char b, ColorMode mode);
+
+// Packed 0xRRGGBB value of an entry of the 256-color ANSI palette
+uint32_t Encoder_ansiPaletteColor(int index);
+
+#endif // ENCODER_H
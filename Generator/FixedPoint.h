@@ -0,0 +1,114 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../Kernels/Kernels.h"
+
+// Unsigned 16.16 fixed point brightness used by the fixed_point pipeline:
+// 0 is black and FIXED_WHITE is 255.0
+typedef uint32_t Fixed16;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE   ((Fixed16)1 << FIXED_SHIFT)
+#define FIXED_WHITE ((Fixed16)255 << FIXED_SHIFT)
+
+// Scale of the reciprocals below; large enough that a multiply gives the
+// exact floor of sum / count for every cell below 65536 pixels
+#define FIXED_RECIPROCAL_SHIFT 40
+
+// ceil(2^40 / count) for Fixed_mean and Fixed_divide, count > 0
+static inline uint64_t Fixed_reciprocal(uint64_t count) {
+    return ((1ull << FIXED_RECIPROCAL_SHIFT) + count - 1) / count;
+}
+
+// floor(sum / count) of byte sums, through the reciprocal of count
+static inline uint32_t Fixed_divide(uint64_t sum, uint64_t reciprocal) {
+    return (uint32_t)((sum * reciprocal) >> FIXED_RECIPROCAL_SHIFT);
+}
+
+// sum / count of byte sums in 16.16, through the reciprocal of count
+static inline Fixed16 Fixed_mean(uint64_t sum, uint64_t reciprocal) {
+    Fixed16 mean = (Fixed16)((sum * reciprocal) >> (FIXED_RECIPROCAL_SHIFT - FIXED_SHIFT));
+    return mean < FIXED_WHITE ? mean : FIXED_WHITE;
+}
+
+// BT.709 luminance of a color in 16.16, with the weights of Kernels_lumaFixed
+static inline Fixed16 Fixed_luma(uint8_t r, uint8_t g, uint8_t b) {
+    uint32_t sum = (uint32_t)r * KERNELS_LUMA_FIXED_R + (uint32_t)g * KERNELS_LUMA_FIXED_G + (uint32_t)b * KERNELS_LUMA_FIXED_B;
+    return sum << (FIXED_SHIFT - KERNELS_LUMA_FIXED_SHIFT);
+}
+
+// Entry of a `levels`-entry ramp covering a brightness: floor(value / 255 * (levels - 1))
+static inline int Fixed_levelIndex(Fixed16 value, int levels) {
+    // the divisor is a constant, so this compiles to a multiply
+    int index = (int)(((uint64_t)value * (uint32_t)(levels - 1)) / FIXED_WHITE);
+    return index < levels ? index : levels - 1;
+}
+
+// Brightness of entry `index` of a `levels`-entry ramp
+static inline Fixed16 Fixed_levelValue(int index, int levels) {
+    return (Fixed16)(((uint64_t)index * FIXED_WHITE) / (uint32_t)(levels - 1));
+}
+
+// Nearest byte, halves rounding up
+static inline uint8_t Fixed_toByte(Fixed16 value) {
+    return (uint8_t)((value + FIXED_ONE / 2) >> FIXED_SHIFT);
+}
+
+// Integer cells of a columns x rows grid over a width x height image: column
+// i spans x[i] .. x[i + 1] and row j spans y[j] .. y[j + 1]. Sizes differ by
+// at most one pixel per axis, so the four possible areas are inverted once.
+typedef struct FixedGrid {
+    int* x;             // columns + 1 edges
+    int* y;             // rows + 1 edges
+    int columns;
+    int rows;
+    int cell_width;     // narrowest nonempty cell
+    int cell_height;
+    uint64_t reciprocal[2][2];  // of (cell_width + i) * (cell_height + j)
+} FixedGrid;
+
+// `x` and `y` must hold columns + 1 and rows + 1 ints
+static inline void FixedGrid_init(FixedGrid* grid, int* x, int* y,
+                                  int width, int height, int columns, int rows) {
+    for (int i = 0; i <= columns; i++)
+        x[i] = (int)((int64_t)i * width / columns);
+    for (int j = 0; j <= rows; j++)
+        y[j] = (int)((int64_t)j * height / rows);
+
+    grid->x = x;
+    grid->y = y;
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->cell_width = (width >= columns) ? width / columns : 1;
+    grid->cell_height = (height >= rows) ? height / rows : 1;
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++)
+            grid->reciprocal[i][j] = Fixed_reciprocal((uint64_t)(grid->cell_width + i) * (grid->cell_height + j));
+    }
+}
+
+// Bounds of cell (cx, cy); with `widen`, cells that fall between two pixels
+// (more cells than pixels) take the pixel they start on instead of none
+static inline void FixedGrid_cell(const FixedGrid* grid, int cx, int cy, bool widen,
+                                  int* x0, int* y0, int* x1, int* y1) {
+    *x0 = grid->x[cx];
+    *x1 = grid->x[cx + 1];
+    *y0 = grid->y[cy];
+    *y1 = grid->y[cy + 1];
+
+    if (widen) {
+        if (*x1 <= *x0) *x1 = *x0 + 1;
+        if (*y1 <= *y0) *y1 = *y0 + 1;
+    }
+}
+
+// Reciprocal of the area of a nonempty w x h cell of `grid`
+static inline uint64_t FixedGrid_reciprocal(const FixedGrid* grid, int w, int h) {
+    return grid->reciprocal[w - grid->cell_width][h - grid->cell_height];
+}
+
+#endif // FIXEDPOINT_H
@@ -0,0 +1,62 @@
+#include "Gamma.h"
+
+static GammaTables tables;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static inline double _toLinear(double srgb) {
+    return (srgb <= 0.04045) ? srgb / 12.92 : pow((srgb + 0.055) / 1.055, 2.4);
+}
+
+static inline double _toSRGB(double linear) {
+    return (linear <= 0.0031308) ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055;
+}
+
+static void _init(void) {
+    const double max_linear = (double)((1 << GAMMA_LINEAR_BITS) - 1);
+    const int step = 1 << (GAMMA_LINEAR_BITS - GAMMA_INVERSE_BITS);
+
+    for (int v = 0; v < 256; v++)
+        tables.to_linear[v] = (uint16_t)lround(_toLinear(v / 255.0) * max_linear);
+
+    // each entry covers `step` linear values and takes the sRGB value of its middle
+    for (int i = 0; i < GAMMA_INVERSE_SIZE; i++) {
+        double linear = (i * step + step / 2) / max_linear;
+        tables.to_srgb[i] = (uint8_t)lround(fmin(_toSRGB(linear), 1.0) * 255.0);
+    }
+}
+
+const GammaTables* Gamma_tables(void) {
+    pthread_once(&tables_once, _init);
+    return &tables;
+}
+
+uint64_t Gamma_sumBlock(const GammaTables* gamma, const uint8_t* data, size_t stride, int width, int height) {
+    const uint16_t* lut = gamma->to_linear;
+    uint64_t total = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        for (int x = 0; x < width; x++)
+            total += lut[data[x]];
+    }
+
+    return total;
+}
+
+void Gamma_sumBlockRGB(const GammaTables* gamma, const uint8_t* data, size_t stride,
+                       int width, int height, int channels, uint64_t sums[3]) {
+    const uint16_t* lut = gamma->to_linear;
+    uint64_t r = 0, g = 0, b = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        const uint8_t* p = data;
+        for (int x = 0; x < width; x++, p += channels) {
+            r += lut[p[0]];
+            g += lut[p[1]];
+            b += lut[p[2]];
+        }
+    }
+
+    sums[0] = r;
+    sums[1] = g;
+    sums[2] = b;
+}
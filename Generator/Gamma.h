@@ -0,0 +1,35 @@
+#ifndef GAMMA_H
+#define GAMMA_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Linear light is held in 16 bits (0..65535); the inverse table has one
+// entry per 16 linear steps, fine enough that every sRGB byte survives a
+// round trip (the darkest values are 20 linear steps apart)
+#define GAMMA_LINEAR_BITS   16
+#define GAMMA_INVERSE_BITS  12
+#define GAMMA_INVERSE_SIZE  (1 << GAMMA_INVERSE_BITS)
+
+typedef struct GammaTables {
+    uint16_t to_linear[256];                // sRGB byte -> linear light
+    uint8_t to_srgb[GAMMA_INVERSE_SIZE];    // linear light >> 4 -> nearest sRGB byte
+} GammaTables;
+
+// Tables built on first use; safe to call from any thread
+const GammaTables* Gamma_tables(void);
+
+static inline uint8_t Gamma_toSRGB(const GammaTables* gamma, uint32_t linear) {
+    return gamma->to_srgb[linear >> (GAMMA_LINEAR_BITS - GAMMA_INVERSE_BITS)];
+}
+
+// Sum of the linear light of a width x height block of bytes, rows `stride` apart
+uint64_t Gamma_sumBlock(const GammaTables* gamma, const uint8_t* data, size_t stride, int width, int height);
+
+// Same as Gamma_sumBlock for the first three channels of interleaved pixels
+void Gamma_sumBlockRGB(const GammaTables* gamma, const uint8_t* data, size_t stride,
+                       int width, int height, int channels, uint64_t sums[3]);
+
+#endif // GAMMA_H
@@ -1,4 +1,11 @@
 #include "Generator.h"
+#include "GeneratorContext.h"
+
+#include <sys/mman.h>
+
+// Bump whenever the rendered bytes change for the same input and config,
+// so that stale cache entries stop matching
+#define GENERATOR_CACHE_VERSION 2
 
 static inline void _getTerminalDimensions(int* width, int* height) {
     struct winsize w;
@@ -23,7 +30,81 @@ static inline char _brightness2Char(float brightness, const char* char_set) {
     return char_set[idx];
 }
 
-static inline float _sampleRegion(Image* gray_img, int x0, int y0, int x1, int y1, bool use_avg) {
+// Pixel (x, y) of a color image of either layout; gray sources give gray
+static inline void _pixelRGB(const Image* rgb_img, int x, int y,
+                             unsigned char* out_r, unsigned char* out_g, unsigned char* out_b) {
+    if (rgb_img->channels < 3) {
+        const unsigned char* p = (rgb_img->layout == IMAGE_PLANAR) ? rgb_img->planes[0] + (size_t)y * rgb_img->stride + x
+                                                                   : Image_row(rgb_img, y) + (size_t)x * rgb_img->channels;
+        *out_r = *out_g = *out_b = p[0];
+        return;
+    }
+
+    if (rgb_img->layout == IMAGE_PLANAR) {
+        size_t idx = (size_t)y * rgb_img->stride + x;
+        *out_r = rgb_img->planes[0][idx];
+        *out_g = rgb_img->planes[1][idx];
+        *out_b = rgb_img->planes[2][idx];
+        return;
+    }
+
+    const unsigned char* p = Image_row(rgb_img, y) + (size_t)x * rgb_img->channels;
+    *out_r = p[0];
+    *out_g = p[1];
+    *out_b = p[2];
+}
+
+// Sum of the gray channel of a block of a gray or gray + alpha image
+static inline uint64_t _sumBlockGray(const Image* img, const GammaTables* gamma,
+                                     int x0, int y0, int width, int height) {
+    const unsigned char* block = (img->layout == IMAGE_PLANAR) ? img->planes[0] + (size_t)y0 * img->stride + x0
+                                                               : Image_row(img, y0) + (size_t)x0 * img->channels;
+    if (img->channels == 1 || img->layout == IMAGE_PLANAR)
+        return gamma ? Gamma_sumBlock(gamma, block, img->stride, width, height)
+                     : Kernels_get()->sumBlock(block, img->stride, width, height);
+
+    uint64_t total = 0;
+    for (int y = 0; y < height; y++, block += img->stride) {
+        for (int x = 0; x < width; x++)
+            total += gamma ? gamma->to_linear[block[2 * x]] : block[2 * x];
+    }
+    return total;
+}
+
+// Channel sums of a block of a color image of either layout, in linear light
+// with `gamma`; gray sources sum to the same value in every channel
+static inline void _sumBlockRGB(const Image* rgb_img, const GammaTables* gamma,
+                                int x0, int y0, int width, int height, uint64_t sums[3]) {
+    const Kernels* kernels = Kernels_get();
+
+    if (rgb_img->channels < 3) {
+        sums[0] = sums[1] = sums[2] = _sumBlockGray(rgb_img, gamma, x0, y0, width, height);
+        return;
+    }
+
+    if (rgb_img->layout == IMAGE_PLANAR) {
+        size_t offset = (size_t)y0 * rgb_img->stride + x0;
+        const unsigned char* blocks[3] = { rgb_img->planes[0] + offset, rgb_img->planes[1] + offset, rgb_img->planes[2] + offset };
+        if (!gamma) {
+            kernels->sumBlockPlanes(blocks, rgb_img->stride, width, height, sums);
+            return;
+        }
+
+        for (int c = 0; c < 3; c++)
+            sums[c] = Gamma_sumBlock(gamma, blocks[c], rgb_img->stride, width, height);
+        return;
+    }
+
+    const unsigned char* block = Image_row(rgb_img, y0) + (size_t)x0 * rgb_img->channels;
+    if (gamma)
+        Gamma_sumBlockRGB(gamma, block, rgb_img->stride, width, height, rgb_img->channels, sums);
+    else
+        kernels->sumBlockRGB(block, rgb_img->stride, width, height, rgb_img->channels, sums);
+}
+
+// `gamma` averages in linear light, NULL averages the gamma-encoded bytes
+static inline float _sampleRegion(Image* gray_img, int x0, int y0, int x1, int y1, bool use_avg,
+                                  const GammaTables* gamma) {
     // clamp values to image bounds
     x0 = (x0 < 0) ? 0 : x0;
     y0 = (y0 < 0) ? 0 : y0;
@@ -33,22 +114,22 @@ static inline float _sampleRegion(Image* gray_img, int x0, int y0, int x1, int y
     if (x0 >= x1 || y0 > y1) return 0.0f;
 
     if (!use_avg)
-        return (float)gray_img->data[y0 * gray_img->width + x0];
-
-    int count = 0;
-    float total = 0.0f;
-    for (int yy = y0; yy < y1; yy++) {
-        for (int xx = x0; xx < x1; xx++) {
-            total += gray_img->data[yy * gray_img->width + xx];
-            count++;
-        }
-    }
+        return (float)Image_row(gray_img, y0)[x0];
+
+    int count = (x1 - x0) * (y1 - y0);
+    if (count <= 0) return 0.0f;
+
+    const unsigned char* block = Image_row(gray_img, y0) + x0;
+    if (gamma)
+        return (float)Gamma_toSRGB(gamma, (uint32_t)(Gamma_sumBlock(gamma, block, gray_img->stride, x1 - x0, y1 - y0) / count));
 
-    return (count > 0) ? total / count : 0.0f;
+    uint64_t total = Kernels_get()->sumBlock(block, gray_img->stride, x1 - x0, y1 - y0);
+
+    return (float)total / count;
 }
 
 static inline void _sampleRGBRegion(Image* rgb_img, int x0, int y0, int x1, int y1,
-                                    bool use_avg,
+                                    bool use_avg, const GammaTables* gamma,
                                     unsigned char* out_r,
                                     unsigned char* out_g,
                                     unsigned char* out_b) {
@@ -63,140 +144,177 @@ static inline void _sampleRGBRegion(Image* rgb_img, int x0, int y0, int x1, int
     } 
 
     if (!use_avg) {
-        int idx = y0 * rgb_img->width + x0;
-        *out_r = rgb_img->data[idx * rgb_img->channels + 0];
-        *out_g = rgb_img->data[idx * rgb_img->channels + 1];
-        *out_b = rgb_img->data[idx * rgb_img->channels + 2];
+        _pixelRGB(rgb_img, x0, y0, out_r, out_g, out_b);
         return;
     }
 
-    int count = 0;
-    long long sum_r = 0, sum_g = 0, sum_b = 0;
-    for (int yy = y0; yy < y1; yy++) {
-        for (int xx = x0; xx < x1; xx++) {
-            int pixel_idx = yy * rgb_img->width + xx;
-            sum_r += rgb_img->data[pixel_idx * rgb_img->channels + 0];
-            sum_g += rgb_img->data[pixel_idx * rgb_img->channels + 1];
-            sum_b += rgb_img->data[pixel_idx * rgb_img->channels + 2];
-            count++;
-        }
+    int count = (x1 - x0) * (y1 - y0);
+    if (count <= 0) {
+        *out_r = *out_g = *out_b = 0;
+        return;
     }
 
-    if (count > 0) {
-        *out_r = (unsigned char)(sum_r / count);
-        *out_g = (unsigned char)(sum_g / count);
-        *out_b = (unsigned char)(sum_b / count);
-    } else {
+    uint64_t sums[3];
+    _sumBlockRGB(rgb_img, gamma, x0, y0, x1 - x0, y1 - y0, sums);
+
+    if (gamma) {
+        *out_r = Gamma_toSRGB(gamma, (uint32_t)(sums[0] / count));
+        *out_g = Gamma_toSRGB(gamma, (uint32_t)(sums[1] / count));
+        *out_b = Gamma_toSRGB(gamma, (uint32_t)(sums[2] / count));
+        return;
+    }
+
+    *out_r = (unsigned char)(sums[0] / count);
+    *out_g = (unsigned char)(sums[1] / count);
+    *out_b = (unsigned char)(sums[2] / count);
+}
+
+// Largest channel value of a resampled sum: linear light or a byte
+static inline int64_t _resampleWhite(const GammaTables* gamma) {
+    return gamma ? (1 << GAMMA_LINEAR_BITS) - 1 : 255;
+}
+
+// Brightness (and color) of cell (cx, cy) from the filtered sums of `resampled`
+static inline float _sampleResampled(const ASCIIGenConfig* config, const GammaTables* gamma,
+                                     const ResampleGrid* resampled, int cx, int cy,
+                                     unsigned char* out_r,
+                                     unsigned char* out_g,
+                                     unsigned char* out_b) {
+    int64_t white = _resampleWhite(gamma);
+
+    if (config->color_mode == COLOR_NONE) {
         *out_r = *out_g = *out_b = 0;
+
+        uint64_t total = ResampleGrid_sum(resampled, 0, cx, cy, white);
+        if (gamma)
+            return (float)Gamma_toSRGB(gamma, (uint32_t)(total / resampled->weight));
+
+        return (float)((double)total / resampled->weight);
+    }
+
+    unsigned char* out[3] = { out_r, out_g, out_b };
+    for (int c = 0; c < 3; c++) {
+        uint64_t mean = ResampleGrid_sum(resampled, c, cx, cy, white) / resampled->weight;
+        *out[c] = gamma ? Gamma_toSRGB(gamma, (uint32_t)mean) : (unsigned char)mean;
     }
+
+    return 0.2126f*(*out_r) + 0.7152f*(*out_g) + 0.0722f*(*out_b);
 }
 
-static inline void _computeASCIIDims(Image* img, const ASCIIGenConfig* config,
-                                     int term_width, int term_height,
-                                     int* out_width, int* out_height,
-                                     float* out_scale_x, float* out_scale_y) {
-    // target ratio constrined by term_width and term_height
-    float target_ratio = ((float)img->width / img->height) * config->terminal_aspect_ratio;
-    
-    // max posisble width and height in characters
-    int max_width = term_width;
-    int max_height = term_height;
-
-    // try to fit by width first
-    int w_by_width = max_width;
-    int h_by_width = (int)((float)w_by_width / target_ratio);
-    if (h_by_width > max_height) {
-        // fit by height
-        int h_by_height = max_height;
-        int w_by_height = (int)(h_by_height * target_ratio);
-
-        *out_width = w_by_height;
-        *out_height = h_by_height;
-    } else {
-        *out_width = w_by_width;
-        *out_height = h_by_width;
+// Filter of a sampling mode other than SAMPLING_BLOCK
+static inline ResampleFilter _resampleFilter(SamplingMode sampling) {
+    switch (sampling) {
+        case SAMPLING_TRIANGLE: return RESAMPLE_TRIANGLE;
+        case SAMPLING_LANCZOS: return RESAMPLE_LANCZOS;
+        default: return RESAMPLE_BOX;
     }
+}
 
-    // avoid zero dimensions
-    if (*out_width <= 0) *out_width = 1;
-    if (*out_height <= 0) *out_height = 1;
+// Tables for linear-light averaging, NULL when `config` averages the gamma-encoded values
+static inline const GammaTables* _gammaTables(const ASCIIGenConfig* config) {
+    return (config->linear_light && config->use_average_pooling) ? Gamma_tables() : NULL;
+}
 
-    *out_scale_x = (float)img->width / *out_width;
-    *out_scale_y = (float)img->height / *out_height;
+static inline int _clampCells(float cells) {
+    // the float may be far outside int range for extreme aspect ratios
+    if (!(cells >= 1.0f)) return 1;
+    if (cells >= (float)INT_MAX) return INT_MAX;
+    return (int)cells;
 }
 
-static inline int _rgbToAnsi256(unsigned char r, unsigned char g, unsigned char b) {
-    // convert each channel from 0-255 to a 0-5 scale
-    int r6 = (r * 6) / 256;
-    int g6 = (g * 6) / 256;
-    int b6 = (b * 6) / 256;
-    
-    // clamp just for safety
-    if (r6 > 5) r6 = 5;
-    if (g6 > 5) g6 = 5;
-    if (b6 > 5) b6 = 5;
+static inline bool _hasCrop(const ASCIIGenConfig* config) {
+    return config->crop.width != 0 || config->crop.height != 0;
+}
 
-    // compute and return index
-    return 16 + (36 * r6) + (6 * g6) + b6;
+// The part of `img` rendered with `config`: `view` of the crop block, or `img`
+// itself without one; NULL when the block is not inside the image
+static inline Image* _cropImage(Image* img, const ASCIIGenConfig* config, Image* view) {
+    if (!_hasCrop(config)) return img;
+
+    return Image_view(img, config->crop, view) ? view : NULL;
 }
 
-static inline int _rgbToAnsi16(unsigned char r, unsigned char g, unsigned char b) {
-    static const unsigned char ANSI16_RGB[16][3] = {
-        {  0,   0,   0  }, { 128, 0,  0  }, { 0, 128,  0  }, { 128, 128,  0  },
-        {  0 ,  0,  128 }, { 128, 0, 128 }, { 0, 128, 128 }, { 192, 192, 192 },
-        { 128, 128, 128 }, { 255, 0,  0  }, { 0, 255,  0  }, { 255, 255,  0  },
-        {  0,   0,  255 }, { 255, 0, 255 }, { 0, 255, 255 }, { 255, 255, 255 }
-    };
+static inline void _computeASCIIDims(int width, int height, const ASCIIGenConfig* config,
+                                     int* out_width, int* out_height,
+                                     float* out_scale_x, float* out_scale_y) {
+    // target ratio constrined by term_width and term_height
+    float target_ratio = ((float)width / height) * config->terminal_aspect_ratio;
 
-    int best_index = 0;
-    long long min_dist = LLONG_MAX;
+    if (config->columns > 0 && config->rows > 0) {
+        *out_width = config->columns;
+        *out_height = config->rows;
+    } else if (config->columns > 0) {
+        *out_width = config->columns;
+        *out_height = _clampCells((float)config->columns / target_ratio);
+    } else if (config->rows > 0) {
+        *out_width = _clampCells(config->rows * target_ratio);
+        *out_height = config->rows;
+    } else {
+        int term_width, term_height;
+        _getTerminalDimensions(&term_width, &term_height);
 
-    for (int i = 0; i < 16; i++) {
-        long long dr = r - ANSI16_RGB[i][0];
-        long long dg = g - ANSI16_RGB[i][1];
-        long long db = b - ANSI16_RGB[i][2];
+        // max posisble width and height in characters
+        int max_width = term_width;
+        int max_height = term_height;
 
-        long long dist = dr*dr + dg*dg + db*db;
+        // try to fit by width first
+        int w_by_width = max_width;
+        int h_by_width = (int)((float)w_by_width / target_ratio);
+        if (h_by_width > max_height) {
+            // fit by height
+            int h_by_height = max_height;
+            int w_by_height = (int)(h_by_height * target_ratio);
 
-        if (dist < min_dist) {
-            min_dist = dist;
-            best_index = i;
+            *out_width = w_by_height;
+            *out_height = h_by_height;
+        } else {
+            *out_width = w_by_width;
+            *out_height = h_by_width;
         }
     }
 
-    return best_index;
+    // avoid zero dimensions
+    if (*out_width <= 0) *out_width = 1;
+    if (*out_height <= 0) *out_height = 1;
+
+    *out_scale_x = (float)width / *out_width;
+    *out_scale_y = (float)height / *out_height;
 }
 
-static inline void _rgbToAnsiEscape(unsigned char r, unsigned char g, unsigned char b,
-                                    ColorMode mode,
-                                    char* out_buffer, size_t buffer_size) {
+static inline void _subpixelLayout(GlyphMode mode, int* sub_cols, int* sub_rows) {
+    if (mode == GLYPH_BRAILLE) {
+        *sub_cols = SUBPIXEL_BRAILLE_COLS;
+        *sub_rows = SUBPIXEL_BRAILLE_ROWS;
+    } else if (mode == GLYPH_SEXTANT) {
+        *sub_cols = SUBPIXEL_SEXTANT_COLS;
+        *sub_rows = SUBPIXEL_SEXTANT_ROWS;
+    } else {
+        *sub_cols = 1;
+        *sub_rows = 1;
+    }
+}
+
+// Longest UTF-8 sequence a glyph mode can emit for one cell
+static inline size_t _maxGlyphLength(GlyphMode mode) {
     switch (mode) {
-        case COLOR_16: {
-            int index = _rgbToAnsi16(r, g, b);
-            snprintf(out_buffer, buffer_size, "38;5;%d", index); 
-            break;
-        }
-        case COLOR_256: {
-            int index = _rgbToAnsi256(r, g, b);
-            snprintf(out_buffer, buffer_size, "38;5;%d", index); 
-            break;
-        }
-        case COLOR_TRUE:
-            snprintf(out_buffer, buffer_size, "38;2;%d;%d;%d", r, g, b); 
-            break;
-        default:
-            out_buffer[0] = '\0';
+        case GLYPH_BRAILLE: return 3;    // U+2800..U+28FF
+        case GLYPH_SEXTANT: return 4;    // U+1FB00..U+1FB3B
+        default:            return 1;
     }
 }
 
-static inline void _renderASCIIToFile(FILE* output, 
+static inline void _renderASCIIToGrid(Grid* grid,
                                       Image* render_img,   // grayscale or original
                                       Image* original_img, // always original RGB image
                                       const ASCIIGenConfig* config,
-                                      int ascii_width, int ascii_height, 
-                                      float scale_x, float scale_y) {
-    for (int y = 0; y < ascii_height; y++) {
-        for (int x = 0; x < ascii_width; x++) {
+                                      float scale_x, float scale_y,
+                                      const ResampleGrid* resampled,  // NULL samples whole-pixel blocks
+                                      int row_begin, int row_end) {
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
             int x0 = (int)(x * scale_x);
             int x1 = (int)((x + 1) * scale_x);
             int y0 = (int)(y * scale_y);
@@ -205,27 +323,400 @@ static inline void _renderASCIIToFile(FILE* output,
             float luminance;
             unsigned char avg_r = 0, avg_g = 0, avg_b = 0;
 
-            if (config->color_mode == COLOR_NONE) {
-                luminance = _sampleRegion(render_img, x0, y0, x1, y1, config->use_average_pooling);
+            if (resampled) {
+                luminance = _sampleResampled(config, gamma, resampled, x, y, &avg_r, &avg_g, &avg_b);
+            } else if (config->color_mode == COLOR_NONE) {
+                luminance = _sampleRegion(render_img, x0, y0, x1, y1, config->use_average_pooling, gamma);
             } else {
-                _sampleRGBRegion(original_img, x0, y0, x1, y1, config->use_average_pooling, &avg_r, &avg_g, &avg_b);
+                _sampleRGBRegion(original_img, x0, y0, x1, y1, config->use_average_pooling, gamma, &avg_r, &avg_g, &avg_b);
                 luminance = 0.2126f*avg_r + 0.7152f*avg_g + 0.0722f*avg_b;
             }
 
-            char c = _brightness2Char(luminance, config->char_set);
+            grid->glyphs[i] = (unsigned char)_brightness2Char(luminance, config->char_set);
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
+        }
+    }
+}
+
+// Samples cell (x, y) as a sub_cols x sub_rows grid of luminance values
+// (row-major into `out_luminance`) and returns the average cell color
+static inline void _sampleCellGrid(Image* render_img, Image* original_img,
+                                   const ASCIIGenConfig* config, const GammaTables* gamma,
+                                   int x, int y, int sub_cols, int sub_rows,
+                                   float sub_scale_x, float sub_scale_y,
+                                   const ResampleGrid* sub_resampled,
+                                   float* out_luminance,
+                                   unsigned char* out_r,
+                                   unsigned char* out_g,
+                                   unsigned char* out_b) {
+    int sum_r = 0, sum_g = 0, sum_b = 0;
+
+    for (int sy = 0; sy < sub_rows; sy++) {
+        int gy = y * sub_rows + sy;
+        int y0 = (int)(gy * sub_scale_y);
+        int y1 = (int)((gy + 1) * sub_scale_y);
+        if (y1 <= y0) y1 = y0 + 1;
+
+        for (int sx = 0; sx < sub_cols; sx++) {
+            int gx = x * sub_cols + sx;
+            int x0 = (int)(gx * sub_scale_x);
+            int x1 = (int)((gx + 1) * sub_scale_x);
+            if (x1 <= x0) x1 = x0 + 1;
+
+            float luminance;
+            if (sub_resampled) {
+                unsigned char r, g, b;
+                luminance = _sampleResampled(config, gamma, sub_resampled, gx, gy, &r, &g, &b);
+                sum_r += r;
+                sum_g += g;
+                sum_b += b;
+            } else if (config->color_mode == COLOR_NONE) {
+                luminance = _sampleRegion(render_img, x0, y0, x1, y1, config->use_average_pooling, gamma);
+            } else {
+                unsigned char r, g, b;
+                _sampleRGBRegion(original_img, x0, y0, x1, y1, config->use_average_pooling, gamma, &r, &g, &b);
+                luminance = 0.2126f*r + 0.7152f*g + 0.0722f*b;
+                sum_r += r;
+                sum_g += g;
+                sum_b += b;
+            }
+
+            out_luminance[sy * sub_cols + sx] = luminance;
+        }
+    }
+
+    int samples = sub_cols * sub_rows;
+    *out_r = (unsigned char)(sum_r / samples);
+    *out_g = (unsigned char)(sum_g / samples);
+    *out_b = (unsigned char)(sum_b / samples);
+}
+
+// Each cell is split into sub_cols x sub_rows samples; samples darker than the
+// threshold set their bit (dark = ink, like the dense end of the default charset)
+// and the resulting mask indexes a precomputed UTF-8 glyph table.
+static inline void _renderSubpixelToGrid(Grid* grid,
+                                         Image* render_img,   // grayscale or original
+                                         Image* original_img, // always original RGB image
+                                         const ASCIIGenConfig* config,
+                                         float scale_x, float scale_y,
+                                         const ResampleGrid* sub_resampled,
+                                         int row_begin, int row_end) {
+    bool braille = config->glyph_mode == GLYPH_BRAILLE;
+
+    int sub_cols, sub_rows;
+    _subpixelLayout(config->glyph_mode, &sub_cols, &sub_rows);
+
+    float sub_scale_x = scale_x / sub_cols;
+    float sub_scale_y = scale_y / sub_rows;
+
+    float luminance[SUBPIXEL_BRAILLE_COLS * SUBPIXEL_BRAILLE_ROWS];
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
+            unsigned char avg_r, avg_g, avg_b;
+            _sampleCellGrid(render_img, original_img, config, gamma, x, y, sub_cols, sub_rows,
+                            sub_scale_x, sub_scale_y, sub_resampled, luminance, &avg_r, &avg_g, &avg_b);
+
+            unsigned int mask = 0;
+            for (int sy = 0; sy < sub_rows; sy++) {
+                for (int sx = 0; sx < sub_cols; sx++) {
+                    if (luminance[sy * sub_cols + sx] < SUBPIXEL_THRESHOLD)
+                        mask |= braille ? Subpixel_brailleBit(sx, sy) : Subpixel_sextantBit(sx, sy);
+                }
+            }
+
+            grid->glyphs[i] = (unsigned char)mask;
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
+        }
+    }
+}
+
+// Each cell is sampled as a SHAPE_GRID_COLS x SHAPE_GRID_ROWS patch and matched
+// against the pre-rasterized glyphs of the charset
+static inline void _renderShapeToGrid(Grid* grid,
+                                      Image* render_img,   // grayscale or original
+                                      Image* original_img, // always original RGB image
+                                      const ASCIIGenConfig* config,
+                                      const ShapeMatcher* matcher,
+                                      float scale_x, float scale_y,
+                                      const ResampleGrid* sub_resampled,
+                                      int row_begin, int row_end) {
+    float sub_scale_x = scale_x / SHAPE_GRID_COLS;
+    float sub_scale_y = scale_y / SHAPE_GRID_ROWS;
+
+    float patch[SHAPE_FEATURES];
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
+            unsigned char avg_r, avg_g, avg_b;
+            _sampleCellGrid(render_img, original_img, config, gamma, x, y, SHAPE_GRID_COLS, SHAPE_GRID_ROWS,
+                            sub_scale_x, sub_scale_y, sub_resampled, patch, &avg_r, &avg_g, &avg_b);
+
+            grid->glyphs[i] = (unsigned char)ShapeMatch_findBest(matcher, patch);
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
+        }
+    }
+}
+
+// Mean brightness of a block of `gray_img` in 16.16, see _sampleRegion; the
+// block is a nonempty cell of `grid`
+static inline Fixed16 _sampleRegionFixed(const Image* gray_img, const FixedGrid* grid,
+                                         int x0, int y0, int x1, int y1, bool use_avg,
+                                         const GammaTables* gamma) {
+    const unsigned char* block = Image_row(gray_img, y0) + x0;
+    if (!use_avg)
+        return (Fixed16)block[0] << FIXED_SHIFT;
+
+    uint64_t reciprocal = FixedGrid_reciprocal(grid, x1 - x0, y1 - y0);
+    if (gamma) {
+        uint64_t total = Gamma_sumBlock(gamma, block, gray_img->stride, x1 - x0, y1 - y0);
+        return (Fixed16)Gamma_toSRGB(gamma, Fixed_divide(total, reciprocal)) << FIXED_SHIFT;
+    }
+
+    uint64_t total = Kernels_get()->sumBlock(block, gray_img->stride, x1 - x0, y1 - y0);
+
+    return Fixed_mean(total, reciprocal);
+}
+
+// Average color of a nonempty cell of `grid`, truncated like _sampleRGBRegion
+static inline void _sampleRGBRegionFixed(const Image* rgb_img, const FixedGrid* grid,
+                                         int x0, int y0, int x1, int y1, bool use_avg,
+                                         const GammaTables* gamma,
+                                         unsigned char* out_r,
+                                         unsigned char* out_g,
+                                         unsigned char* out_b) {
+    if (!use_avg) {
+        _pixelRGB(rgb_img, x0, y0, out_r, out_g, out_b);
+        return;
+    }
+
+    uint64_t sums[3];
+    uint64_t reciprocal = FixedGrid_reciprocal(grid, x1 - x0, y1 - y0);
+    _sumBlockRGB(rgb_img, gamma, x0, y0, x1 - x0, y1 - y0, sums);
+
+    if (gamma) {
+        *out_r = Gamma_toSRGB(gamma, Fixed_divide(sums[0], reciprocal));
+        *out_g = Gamma_toSRGB(gamma, Fixed_divide(sums[1], reciprocal));
+        *out_b = Gamma_toSRGB(gamma, Fixed_divide(sums[2], reciprocal));
+        return;
+    }
+
+    *out_r = (unsigned char)Fixed_divide(sums[0], reciprocal);
+    *out_g = (unsigned char)Fixed_divide(sums[1], reciprocal);
+    *out_b = (unsigned char)Fixed_divide(sums[2], reciprocal);
+}
+
+// Brightness (and color) of a nonempty cell of `grid` in the fixed point pipeline
+static inline Fixed16 _sampleCellFixed(const Image* render_img, const Image* original_img,
+                                       const ASCIIGenConfig* config, const GammaTables* gamma,
+                                       const FixedGrid* grid,
+                                       int x0, int y0, int x1, int y1,
+                                       unsigned char* out_r,
+                                       unsigned char* out_g,
+                                       unsigned char* out_b) {
+    if (config->color_mode == COLOR_NONE) {
+        *out_r = *out_g = *out_b = 0;
+        return _sampleRegionFixed(render_img, grid, x0, y0, x1, y1, config->use_average_pooling, gamma);
+    }
+
+    _sampleRGBRegionFixed(original_img, grid, x0, y0, x1, y1, config->use_average_pooling, gamma, out_r, out_g, out_b);
+    return Fixed_luma(*out_r, *out_g, *out_b);
+}
+
+// _sampleResampled in 16.16 through the reciprocal of the cell weight; the
+// reciprocal rounds up, so a white cell can come out one step over white
+static inline Fixed16 _sampleResampledFixed(const ASCIIGenConfig* config, const GammaTables* gamma,
+                                            const ResampleGrid* resampled, int cx, int cy,
+                                            unsigned char* out_r,
+                                            unsigned char* out_g,
+                                            unsigned char* out_b) {
+    int64_t white = _resampleWhite(gamma);
+
+    if (config->color_mode == COLOR_NONE) {
+        *out_r = *out_g = *out_b = 0;
+
+        uint64_t total = ResampleGrid_sum(resampled, 0, cx, cy, white);
+        if (gamma) {
+            uint32_t mean = Fixed_divide(total, resampled->reciprocal);
+            return (Fixed16)Gamma_toSRGB(gamma, mean < white ? mean : (uint32_t)white) << FIXED_SHIFT;
+        }
+
+        return Fixed_mean(total, resampled->reciprocal);
+    }
+
+    unsigned char* out[3] = { out_r, out_g, out_b };
+    for (int c = 0; c < 3; c++) {
+        uint32_t mean = Fixed_divide(ResampleGrid_sum(resampled, c, cx, cy, white), resampled->reciprocal);
+        if (mean > white) mean = (uint32_t)white;
+        *out[c] = gamma ? Gamma_toSRGB(gamma, mean) : (unsigned char)mean;
+    }
+
+    return Fixed_luma(*out_r, *out_g, *out_b);
+}
+
+// _renderASCIIToGrid over the integer cells of `grid`
+static inline void _renderASCIIToGridFixed(Grid* grid,
+                                           Image* render_img,   // grayscale or original
+                                           Image* original_img, // always original RGB image
+                                           const ASCIIGenConfig* config,
+                                           const FixedGrid* cells,
+                                           const ResampleGrid* resampled,
+                                           int row_begin, int row_end) {
+    int len = (int)strlen(config->char_set);
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
+            int x0, y0, x1, y1;
+            FixedGrid_cell(cells, x, y, false, &x0, &y0, &x1, &y1);
+
+            // cells between two pixels stay black, as in the float pipeline
+            Fixed16 luminance = 0;
+            unsigned char avg_r = 0, avg_g = 0, avg_b = 0;
+            if (resampled)
+                luminance = _sampleResampledFixed(config, gamma, resampled, x, y, &avg_r, &avg_g, &avg_b);
+            else if (x1 > x0 && y1 > y0)
+                luminance = _sampleCellFixed(render_img, original_img, config, gamma, cells, x0, y0, x1, y1, &avg_r, &avg_g, &avg_b);
+
+            grid->glyphs[i] = (unsigned char)config->char_set[Fixed_levelIndex(luminance, len)];
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
+        }
+    }
+}
+
+// _sampleCellGrid over the sub-cells of `sub_grid`, which has sub_cols x
+// sub_rows of them per cell
+static inline void _sampleCellGridFixed(Image* render_img, Image* original_img,
+                                        const ASCIIGenConfig* config, const GammaTables* gamma,
+                                        const FixedGrid* sub_grid, const ResampleGrid* sub_resampled,
+                                        int x, int y, int sub_cols, int sub_rows,
+                                        Fixed16* out_luminance,
+                                        unsigned char* out_r,
+                                        unsigned char* out_g,
+                                        unsigned char* out_b) {
+    int sum_r = 0, sum_g = 0, sum_b = 0;
+
+    for (int sy = 0; sy < sub_rows; sy++) {
+        for (int sx = 0; sx < sub_cols; sx++) {
+            int gx = x * sub_cols + sx;
+            int gy = y * sub_rows + sy;
 
-            if (config->color_mode != COLOR_NONE) {
-                char ansi_payload[32];
-                _rgbToAnsiEscape(avg_r, avg_g, avg_b, config->color_mode, ansi_payload, sizeof(ansi_payload));
-                fprintf(output, "\x1b[%sm%c\x1b[0m", ansi_payload, c);
+            unsigned char r, g, b;
+            if (sub_resampled) {
+                out_luminance[sy * sub_cols + sx] = _sampleResampledFixed(config, gamma, sub_resampled, gx, gy, &r, &g, &b);
             } else {
-                fputc(c, output);
+                int x0, y0, x1, y1;
+                FixedGrid_cell(sub_grid, gx, gy, true, &x0, &y0, &x1, &y1);
+                out_luminance[sy * sub_cols + sx] = _sampleCellFixed(render_img, original_img, config, gamma, sub_grid,
+                                                                     x0, y0, x1, y1, &r, &g, &b);
             }
+            sum_r += r;
+            sum_g += g;
+            sum_b += b;
+        }
+    }
+
+    int samples = sub_cols * sub_rows;
+    *out_r = (unsigned char)(sum_r / samples);
+    *out_g = (unsigned char)(sum_g / samples);
+    *out_b = (unsigned char)(sum_b / samples);
+}
+
+// _renderSubpixelToGrid over the integer sub-cells of `sub_grid`
+static inline void _renderSubpixelToGridFixed(Grid* grid,
+                                              Image* render_img,   // grayscale or original
+                                              Image* original_img, // always original RGB image
+                                              const ASCIIGenConfig* config,
+                                              const FixedGrid* sub_grid,
+                                              const ResampleGrid* sub_resampled,
+                                              int row_begin, int row_end) {
+    bool braille = config->glyph_mode == GLYPH_BRAILLE;
+
+    int sub_cols, sub_rows;
+    _subpixelLayout(config->glyph_mode, &sub_cols, &sub_rows);
+
+    const Fixed16 threshold = (Fixed16)(SUBPIXEL_THRESHOLD * FIXED_ONE);
+    Fixed16 luminance[SUBPIXEL_BRAILLE_COLS * SUBPIXEL_BRAILLE_ROWS];
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
+            unsigned char avg_r, avg_g, avg_b;
+            _sampleCellGridFixed(render_img, original_img, config, gamma, sub_grid, sub_resampled, x, y, sub_cols, sub_rows,
+                                 luminance, &avg_r, &avg_g, &avg_b);
+
+            unsigned int mask = 0;
+            for (int sy = 0; sy < sub_rows; sy++) {
+                for (int sx = 0; sx < sub_cols; sx++) {
+                    if (luminance[sy * sub_cols + sx] < threshold)
+                        mask |= braille ? Subpixel_brailleBit(sx, sy) : Subpixel_sextantBit(sx, sy);
+                }
+            }
+
+            grid->glyphs[i] = (unsigned char)mask;
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
         }
-        fputc('\n', output);
     }
 }
 
+// _renderShapeToGrid over the integer sub-cells of `sub_grid`; the patch is
+// handed to the matcher as exact floats (16.16 values fit a float mantissa)
+static inline void _renderShapeToGridFixed(Grid* grid,
+                                           Image* render_img,   // grayscale or original
+                                           Image* original_img, // always original RGB image
+                                           const ASCIIGenConfig* config,
+                                           const ShapeMatcher* matcher,
+                                           const FixedGrid* sub_grid,
+                                           const ResampleGrid* sub_resampled,
+                                           int row_begin, int row_end) {
+    Fixed16 luminance[SHAPE_FEATURES];
+    float patch[SHAPE_FEATURES];
+    const GammaTables* gamma = _gammaTables(config);
+
+    size_t i = (size_t)row_begin * grid->columns;
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < grid->columns; x++, i++) {
+            unsigned char avg_r, avg_g, avg_b;
+            _sampleCellGridFixed(render_img, original_img, config, gamma, sub_grid, sub_resampled, x, y, SHAPE_GRID_COLS, SHAPE_GRID_ROWS,
+                                 luminance, &avg_r, &avg_g, &avg_b);
+
+            for (int k = 0; k < SHAPE_FEATURES; k++)
+                patch[k] = (float)luminance[k] / FIXED_ONE;
+
+            grid->glyphs[i] = (unsigned char)ShapeMatch_findBest(matcher, patch);
+            grid->r[i] = avg_r;
+            grid->g[i] = avg_g;
+            grid->b[i] = avg_b;
+        }
+    }
+}
+
+// Integer cells of a columns x rows grid over `img`, from the arena
+static inline bool _createFixedGrid(Arena* arena, const Image* img, int columns, int rows, FixedGrid* grid) {
+    int* x = Arena_alloc(arena, ((size_t)columns + 1) * sizeof(int), ARENA_DEFAULT_ALIGNMENT);
+    int* y = Arena_alloc(arena, ((size_t)rows + 1) * sizeof(int), ARENA_DEFAULT_ALIGNMENT);
+    if (!x || !y) return false;
+
+    FixedGrid_init(grid, x, y, img->width, img->height, columns, rows);
+    return true;
+}
+
 const ASCIIGenConfig DEFAULT_CONFIG = {
     .char_set = "$@B%8&WM#*oahkbdpqwmZO0QLCJUYXzcvunxrjft/\\|()1{}[]?-_+~i!lI;:,^'",
     .terminal_aspect_ratio = 2.0f,
@@ -234,51 +725,671 @@ const ASCIIGenConfig DEFAULT_CONFIG = {
     .color_mode = COLOR_NONE,
     .dither_mode = DITHER_NONE,
     .edge_mode = EDGE_NONE,
+    .glyph_mode = GLYPH_BRIGHTNESS,
+    .output_format = FORMAT_TEXT,
+    .fixed_point = false,
+    .linear_light = false,
+    .sampling = SAMPLING_BLOCK,
+    .layout = IMAGE_INTERLEAVED,
+    .crop = { 0, 0, 0, 0 },
+    .columns = 0,
+    .rows = 0,
+    .threads = 1,
+    .stats = NULL,
 };
 
-bool Generator_generateASCIIFromImage(Image* img, FILE* output, const ASCIIGenConfig* config) {
-    if (!img || !output) return false;
-    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
- 
-    int term_width, term_height;
-    _getTerminalDimensions(&term_width, &term_height);
+// Grayscale conversion of one band of image rows per tile. With edges the
+// band and a row of halo on each side are converted into the worker's own
+// image, and Sobel writes the band's edges from there, so the full-size gray
+// image is written once and never read back before sampling.
+typedef struct GrayJob {
+    const Image* src;
+    Image* gray;
+    const ASCIIGenConfig* cfg;
+    int band_rows;
+    int halo;               // 1 with edges, else 0
+    Image** halos;          // with edges: per worker, band_rows + 2 rows
+    bool timed;             // with edges and stats: time both halves of every tile
+    uint64_t gray_ns[TILES_MAX_THREADS];    // per worker
+    uint64_t edge_ns[TILES_MAX_THREADS];
+} GrayJob;
+
+static void _grayTile(void* arg, int tile, int worker) {
+    GrayJob* job = arg;
+    TileBand band = Tiles_band(job->src->height, job->band_rows, job->halo, tile);
+    int width = job->src->width;
+
+    Image src, dst;
+    Image_view(job->src, (ImageRect){ 0, band.halo_y0, width, band.halo_y1 - band.halo_y0 }, &src);
+    if (job->halo > 0)
+        Image_view(job->halos[worker], (ImageRect){ 0, 0, width, band.halo_y1 - band.halo_y0 }, &dst);
+    else
+        Image_view(job->gray, (ImageRect){ 0, band.y0, width, band.y1 - band.y0 }, &dst);
+
+    uint64_t start = job->timed ? Stats_now() : 0;
+
+    if (job->cfg->fixed_point)
+        Image_toGrayscaleFixedInto(&src, &dst, job->cfg->grayscale_method);
+    else
+        Image_toGrayscaleInto(&src, &dst, job->cfg->grayscale_method);
+
+    if (job->halo > 0) {
+        uint64_t split = job->timed ? Stats_now() : 0;
+        Sobel_edgeRows(&dst, band.y0 - band.halo_y0, band.y1 - band.y0, Image_row(job->gray, band.y0), job->gray->stride);
+
+        if (job->timed) {
+            job->gray_ns[worker] += split - start;
+            job->edge_ns[worker] += Stats_now() - split;
+        }
+    }
+}
+
+// Runs grayscale conversion (and edges) over `img` into `gray` in bands sized
+// to stay in L2, spread over `pool`. With edges and stats, `gray_ns` and
+// `edge_ns` receive the thread time each half took, summed over the workers
+static bool _grayscaleTiled(Arena* arena, TilePool* pool, const Image* img, Image* gray, const ASCIIGenConfig* cfg,
+                            uint64_t* gray_ns, uint64_t* edge_ns) {
+    GrayJob job = {
+        .src = img,
+        .gray = gray,
+        .cfg = cfg,
+        .halo = cfg->edge_mode == EDGE_SOBEL ? 1 : 0,
+        .halos = NULL,
+        .timed = cfg->edge_mode == EDGE_SOBEL && cfg->stats,
+    };
+
+    size_t row_bytes = (size_t)img->width * (img->channels + 1 + job.halo);
+    job.band_rows = Tiles_bandRows(row_bytes, job.halo);
+    if (job.band_rows > img->height) job.band_rows = img->height;
+
+    if (job.halo > 0) {
+        int workers = Tiles_workers(pool);
+        job.halos = Arena_alloc(arena, (size_t)workers * sizeof(Image*), ARENA_DEFAULT_ALIGNMENT);
+        if (!job.halos) return false;
+
+        for (int w = 0; w < workers; w++) {
+            job.halos[w] = Image_createInArena(arena, img->width, job.band_rows + 2 * job.halo, 1, false);
+            if (!job.halos[w]) return false;
+        }
+    }
+
+    Tiles_run(pool, Tiles_bandCount(img->height, job.band_rows), _grayTile, &job);
+
+    *gray_ns = *edge_ns = 0;
+    for (int w = 0; job.timed && w < Tiles_workers(pool); w++) {
+        *gray_ns += job.gray_ns[w];
+        *edge_ns += job.edge_ns[w];
+    }
+    return true;
+}
+
+// Sampling state shared by the tiles of one render; each tile fills its own
+// band of grid rows and only reads the images
+typedef struct SampleJob {
+    Grid* grid;
+    Image* render_img;
+    Image* img;
+    const ASCIIGenConfig* cfg;
+    float scale_x;
+    float scale_y;
+    const ResampleGrid* resampled;
+    const ShapeMatcher* matcher;    // shape glyphs only
+    FixedGrid cells;                // fixed point only: the (sub-)cells the glyph mode samples
+    int band_rows;
+} SampleJob;
+
+static void _sampleTile(void* arg, int tile, int worker) {
+    (void)worker;
+    const SampleJob* job = arg;
+    const ASCIIGenConfig* cfg = job->cfg;
+    int begin = tile * job->band_rows;
+    int end = begin + job->band_rows < job->grid->rows ? begin + job->band_rows : job->grid->rows;
+
+    if (cfg->fixed_point) {
+        if (cfg->glyph_mode == GLYPH_BRIGHTNESS)
+            _renderASCIIToGridFixed(job->grid, job->render_img, job->img, cfg, &job->cells, job->resampled, begin, end);
+        else if (cfg->glyph_mode == GLYPH_SHAPE)
+            _renderShapeToGridFixed(job->grid, job->render_img, job->img, cfg, job->matcher, &job->cells, job->resampled, begin, end);
+        else
+            _renderSubpixelToGridFixed(job->grid, job->render_img, job->img, cfg, &job->cells, job->resampled, begin, end);
+    } else if (cfg->glyph_mode == GLYPH_BRIGHTNESS) {
+        _renderASCIIToGrid(job->grid, job->render_img, job->img, cfg, job->scale_x, job->scale_y, job->resampled, begin, end);
+    } else if (cfg->glyph_mode == GLYPH_SHAPE) {
+        _renderShapeToGrid(job->grid, job->render_img, job->img, cfg, job->matcher, job->scale_x, job->scale_y, job->resampled, begin, end);
+    } else {
+        _renderSubpixelToGrid(job->grid, job->render_img, job->img, cfg, job->scale_x, job->scale_y, job->resampled, begin, end);
+    }
+}
+
+// Runs the whole pipeline on `img` and leaves the sampled cells in `grid`
+static bool _sample(GeneratorContext* ctx, Image* img, Grid* grid, const ASCIIGenConfig* cfg) {
+    RenderStats* stats = cfg->stats;
+    StatsTimer timer = { 0 };
+
+    // everything allocated by the previous render is dropped here
+    Arena_reset(&ctx->arena);
+
+    // every stage below only sees (and reads) the pixels of the crop block
+    Image cropped;
+    img = _cropImage(img, cfg, &cropped);
+    if (!img) return false;
 
     int ascii_width, ascii_height;
     float scale_x, scale_y;
-    _computeASCIIDims(img, cfg, term_width, term_height, &ascii_width, &ascii_height, &scale_x, &scale_y);
-    
+    _computeASCIIDims(img->width, img->height, cfg, &ascii_width, &ascii_height, &scale_x, &scale_y);
+
+    TilePool* pool = GeneratorContext_tilePool(ctx, cfg->threads);
     Image* render_img = NULL;
-    bool owns_render_img = false;
+    uint64_t gray_bytes = (uint64_t)img->width * img->height;
 
     if (cfg->color_mode == COLOR_NONE) {
-        render_img = Image_toGrayscale(img, cfg->grayscale_method);
-        owns_render_img = true;
+        Stats_begin(stats, &timer);
+        render_img = Image_createInArena(&ctx->arena, img->width, img->height, 1, false);
+        if (!render_img) return false;
 
+        uint64_t gray_ns, edge_ns;
+        if (!_grayscaleTiled(&ctx->arena, pool, img, render_img, cfg, &gray_ns, &edge_ns))
+            return false;
         if (cfg->edge_mode == EDGE_SOBEL)
-            Sobel_applySobelEdgeDetection(render_img, false, 0.0f);
+            Stats_endShared(stats, &timer, STAGE_GRAYSCALE, gray_bytes * img->channels, gray_ns,
+                            STAGE_EDGES, gray_bytes, edge_ns);
+        else
+            Stats_end(stats, &timer, STAGE_GRAYSCALE, gray_bytes * img->channels);
+
+        // error diffusion carries from each cell into the next, it stays one pass
+        if (cfg->dither_mode == DITHER_FLOYD_STEINBERG) {
+            Stats_begin(stats, &timer);
+            if (cfg->fixed_point) {
+                // same cells as the float version, brightness glyphs dither the cell grid
+                // and the others the sub-cell grid down to two levels
+                bool cells = cfg->glyph_mode == GLYPH_BRIGHTNESS || cfg->glyph_mode == GLYPH_SHAPE;
+                int sub_cols, sub_rows;
+                _subpixelLayout(cells ? GLYPH_BRIGHTNESS : cfg->glyph_mode, &sub_cols, &sub_rows);
 
-        if (cfg->dither_mode == DITHER_FLOYD_STEINBERG)
-            Dithering_applyFloydSteinberg(render_img, ascii_width, ascii_height, scale_x, scale_y, cfg->char_set);
+                FixedGrid dither_grid;
+                if (!_createFixedGrid(&ctx->arena, img, ascii_width * sub_cols, ascii_height * sub_rows, &dither_grid))
+                    return false;
+
+                int32_t* scratch = Arena_alloc(&ctx->arena, (size_t)dither_grid.columns * dither_grid.rows * sizeof(int32_t), ARENA_DEFAULT_ALIGNMENT);
+                Dithering_applyFloydSteinbergFixed(render_img, &dither_grid, cells ? cfg->char_set : " #", scratch);
+            } else if (cfg->glyph_mode == GLYPH_BRIGHTNESS || cfg->glyph_mode == GLYPH_SHAPE) {
+                float* scratch = Arena_alloc(&ctx->arena, (size_t)ascii_width * ascii_height * sizeof(float), ARENA_DEFAULT_ALIGNMENT);
+                Dithering_applyFloydSteinberg(render_img, ascii_width, ascii_height, scale_x, scale_y, cfg->char_set, scratch);
+            } else {
+                // dither the sub-cell grid down to two levels so the threshold picks it up
+                int sub_cols, sub_rows;
+                _subpixelLayout(cfg->glyph_mode, &sub_cols, &sub_rows);
+
+                float* scratch = Arena_alloc(&ctx->arena, (size_t)ascii_width * sub_cols * ascii_height * sub_rows * sizeof(float), ARENA_DEFAULT_ALIGNMENT);
+                Dithering_applyFloydSteinberg(render_img,
+                                              ascii_width * sub_cols, ascii_height * sub_rows,
+                                              scale_x / sub_cols, scale_y / sub_rows,
+                                              " #", scratch);
+            }
+            Stats_end(stats, &timer, STAGE_DITHER, gray_bytes);
+        }
     } else {
         render_img = img;
     }
 
-    _renderASCIIToFile(output, render_img, img, cfg, ascii_width, ascii_height, scale_x, scale_y);
+    Stats_begin(stats, &timer);
+
+    if (!Grid_resize(grid, ascii_width, ascii_height))
+        return false;
+
+    grid->color_mode = cfg->color_mode;
+    grid->cell_aspect_ratio = cfg->terminal_aspect_ratio;
+    if (cfg->glyph_mode == GLYPH_BRAILLE)
+        grid->glyph_table = SUBPIXEL_BRAILLE_GLYPHS;
+    else if (cfg->glyph_mode == GLYPH_SEXTANT)
+        grid->glyph_table = SUBPIXEL_SEXTANT_GLYPHS;
+    else
+        grid->glyph_table = GRID_BYTE_GLYPHS;
+
+    // sample points per cell of the glyph mode
+    int sub_cols, sub_rows;
+    _subpixelLayout(cfg->glyph_mode, &sub_cols, &sub_rows);
+    if (cfg->glyph_mode == GLYPH_SHAPE) {
+        sub_cols = SHAPE_GRID_COLS;
+        sub_rows = SHAPE_GRID_ROWS;
+    }
+
+    SampleJob job = {
+        .grid = grid,
+        .render_img = render_img,
+        .img = img,
+        .cfg = cfg,
+        .scale_x = scale_x,
+        .scale_y = scale_y,
+        .resampled = NULL,
+        .matcher = NULL,
+    };
+
+    // dithered cells already hold their final level, filter weights would blend neighbors in again
+    ResampleGrid resample_grid;
+    bool dithered = cfg->color_mode == COLOR_NONE && cfg->dither_mode != DITHER_NONE;
+
+    if (cfg->sampling != SAMPLING_BLOCK && cfg->use_average_pooling && !dithered) {
+        // every (sub-)cell is filtered in one pass over the image before the glyphs are picked
+        if (!ResampleGrid_build(&resample_grid, &ctx->arena, render_img, _gammaTables(cfg),
+                                ascii_width * sub_cols, ascii_height * sub_rows, _resampleFilter(cfg->sampling)))
+            return false;
+        job.resampled = &resample_grid;
+    }
+
+    if (cfg->glyph_mode == GLYPH_SHAPE) {
+        job.matcher = GeneratorContext_shapeMatcher(ctx, cfg->char_set);
+        if (!job.matcher) return false;
+    }
+
+    if (cfg->fixed_point && !_createFixedGrid(&ctx->arena, img, ascii_width * sub_cols, ascii_height * sub_rows, &job.cells))
+        return false;
+
+    // a few bands per worker, so one slow band does not hold up the others
+    int workers = Tiles_workers(pool);
+    job.band_rows = workers > 1 ? ascii_height / (workers * 4) : ascii_height;
+    if (job.band_rows < 1) job.band_rows = 1;
+
+    Tiles_run(pool, Tiles_bandCount(ascii_height, job.band_rows), _sampleTile, &job);
+
+    Stats_end(stats, &timer, STAGE_SAMPLE, (uint64_t)render_img->width * render_img->height * render_img->channels);
 
-    if (owns_render_img) Image_free(render_img);
-    
     return true;
 }
 
+// Rasterizes the text encoding of `grid` with the embedded font
+static Image* _rasterizeGrid(GeneratorWriter* writer, const Grid* grid, RenderStats* stats) {
+    StatsTimer timer = { 0 };
+    Stats_begin(stats, &timer);
+
+    Arena_reset(&writer->arena);
+
+    Output_reset(&writer->text, NULL);
+    if (!Grid_encode(grid, &writer->encoder, &writer->text, FORMAT_TEXT))
+        return NULL;
+
+    RasterOptions options = DEFAULT_RASTER_OPTIONS;
+
+    // keep the terminal cell proportions so the preview is not squashed
+    options.scale_y = (int)(grid->cell_aspect_ratio * options.scale_x + 0.5f);
+    if (options.scale_y < 1) options.scale_y = 1;
+
+    // same polarity as the text output: dark = ink unless colored
+    if (grid->color_mode == COLOR_NONE) {
+        options.foreground = 0x000000;
+        options.background = 0xFFFFFF;
+    }
+
+    Image* raster = Raster_renderText(writer->text.data, writer->text.length, &options, &writer->arena);
+    Stats_end(stats, &timer, STAGE_RASTER, (uint64_t)Grid_cellCount(grid) * 4);
+
+    return raster;
+}
+
+static Image* _generateImage(GeneratorContext* ctx, Image* img, const ASCIIGenConfig* cfg) {
+    if (!_sample(ctx, img, &ctx->grid, cfg))
+        return NULL;
+
+    return _rasterizeGrid(&ctx->writers[0], &ctx->grid, cfg->stats);
+}
+
+// Encodes `grid` as `format` to `output`, PNG included
+static bool _writeGrid(GeneratorWriter* writer, const Grid* grid, FILE* output, OutputFormat format,
+                       RenderStats* stats) {
+    StatsTimer timer = { 0 };
+
+    if (format == FORMAT_PNG) {
+        Image* raster = _rasterizeGrid(writer, grid, stats);
+        if (!raster) return false;
+
+        Stats_begin(stats, &timer);
+        bool success = Image_writePNG(raster, output);
+        Stats_end(stats, &timer, STAGE_ENCODE, (uint64_t)raster->width * raster->height * raster->channels);
+        Image_free(raster);
+        free(raster);
+
+        return success;
+    }
+
+    Stats_begin(stats, &timer);
+    Output_reset(&writer->output, output);
+    bool success = Grid_encode(grid, &writer->encoder, &writer->output, format);
+    success = Output_flush(&writer->output) && success;
+    Stats_end(stats, &timer, STAGE_ENCODE, (uint64_t)Grid_cellCount(grid) * 4);
+
+    return success;
+}
+
+// Encodes `grid` as `format` into caller memory, see Generator_generateASCIIToBuffer
+static bool _writeGridToBuffer(GeneratorWriter* writer, const Grid* grid,
+                               char* buffer, size_t capacity, size_t* written,
+                               OutputFormat format, RenderStats* stats) {
+    if (format == FORMAT_PNG) {
+        fprintf(stderr, "Generator: PNG output cannot be rendered into a buffer.\n");
+        return false;
+    }
+
+    StatsTimer timer = { 0 };
+    Stats_begin(stats, &timer);
+
+    // cells are encoded straight into the caller's memory
+    OutputBuffer out;
+    Output_initFixed(&out, buffer, capacity);
+
+    bool success = Grid_encode(grid, &writer->encoder, &out, format);
+    Stats_end(stats, &timer, STAGE_ENCODE, (uint64_t)Grid_cellCount(grid) * 4);
+
+    // on overflow length still counts every byte, so it is the exact size needed
+    if (written) *written = out.length;
+
+    return success && out.length <= capacity;
+}
+
+typedef struct SinkJob {
+    GeneratorWriter* writer;
+    const Grid* grid;
+    const GeneratorSink* sink;
+    RenderStats* stats;         // private to the job, merged after the join
+    bool success;
+} SinkJob;
+
+static void* _encodeSink(void* arg) {
+    SinkJob* job = arg;
+
+    // the planes are shared read-only, only the header differs per sink
+    Grid grid = *job->grid;
+    if (job->sink->plain)
+        grid.color_mode = COLOR_NONE;
+
+    job->success = _writeGrid(job->writer, &grid, job->sink->output, job->sink->format, job->stats);
+
+    return NULL;
+}
+
+bool Generator_generateASCIIWithContext(GeneratorContext* ctx, Image* img, FILE* output, const ASCIIGenConfig* config) {
+    if (!ctx || !img || !output) return false;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    if (!_sample(ctx, img, &ctx->grid, cfg))
+        return false;
+
+    return _writeGrid(&ctx->writers[0], &ctx->grid, output, cfg->output_format, cfg->stats);
+}
+
+bool Generator_generateASCIIToBuffer(GeneratorContext* ctx, Image* img,
+                                     char* buffer, size_t capacity, size_t* written,
+                                     const ASCIIGenConfig* config) {
+    if (written) *written = 0;
+    if (!img || (!buffer && capacity > 0)) return false;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    if (cfg->output_format == FORMAT_PNG) {
+        fprintf(stderr, "Generator: PNG output cannot be rendered into a buffer.\n");
+        return false;
+    }
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return false;
+        ctx = &local;
+    }
+
+    bool success = _sample(ctx, img, &ctx->grid, cfg)
+                && _writeGridToBuffer(&ctx->writers[0], &ctx->grid, buffer, capacity, written, cfg->output_format, cfg->stats);
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return success;
+}
+
+char* Generator_generateASCIIToMemory(GeneratorContext* ctx, Image* img, size_t* length,
+                                      const ASCIIGenConfig* config) {
+    if (!img || !length) return NULL;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return NULL;
+        ctx = &local;
+    }
+
+    char* result = NULL;
+    StatsTimer timer = { 0 };
+
+    if (!_sample(ctx, img, &ctx->grid, cfg)) {
+        // nothing to hand out
+    } else if (cfg->output_format == FORMAT_PNG) {
+        Image* raster = _rasterizeGrid(&ctx->writers[0], &ctx->grid, cfg->stats);
+        if (raster) {
+            Stats_begin(cfg->stats, &timer);
+            result = (char*)Image_encodePNG(raster, length);
+            Stats_end(cfg->stats, &timer, STAGE_ENCODE, (uint64_t)raster->width * raster->height * raster->channels);
+            Image_free(raster);
+            free(raster);
+        }
+    } else {
+        Stats_begin(cfg->stats, &timer);
+
+        // a fresh growable buffer whose memory is handed to the caller as is
+        OutputBuffer out;
+        if (Output_initMemory(&out)) {
+            if (Grid_encode(&ctx->grid, &ctx->writers[0].encoder, &out, cfg->output_format)) {
+                result = out.data;
+                *length = out.length;
+            } else {
+                free(out.data);
+            }
+        }
+
+        Stats_end(cfg->stats, &timer, STAGE_ENCODE, (uint64_t)Grid_cellCount(&ctx->grid) * 4);
+    }
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return result;
+}
+
+bool Generator_generateGrid(GeneratorContext* ctx, Image* img, Grid* grid, const ASCIIGenConfig* config) {
+    if (!img || !grid) return false;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return false;
+        ctx = &local;
+    }
+
+    bool success = _sample(ctx, img, grid, cfg);
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return success;
+}
+
+bool Generator_encodeGrid(GeneratorContext* ctx, const Grid* grid, FILE* output, OutputFormat format) {
+    if (!grid || !output || !grid->glyphs) return false;
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return false;
+        ctx = &local;
+    }
+
+    bool success = _writeGrid(&ctx->writers[0], grid, output, format, NULL);
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return success;
+}
+
+bool Generator_encodeGridToBuffer(GeneratorContext* ctx, const Grid* grid,
+                                  char* buffer, size_t capacity, size_t* written,
+                                  OutputFormat format) {
+    if (written) *written = 0;
+    if (!grid || !grid->glyphs || (!buffer && capacity > 0)) return false;
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return false;
+        ctx = &local;
+    }
+
+    bool success = _writeGridToBuffer(&ctx->writers[0], grid, buffer, capacity, written, format, NULL);
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return success;
+}
+
+bool Generator_generateMulti(GeneratorContext* ctx, Image* img,
+                             const GeneratorSink* sinks, int sink_count,
+                             const ASCIIGenConfig* config) {
+    if (!img || !sinks || sink_count <= 0) return false;
+    if (sink_count > GENERATOR_MAX_SINKS) {
+        fprintf(stderr, "Generator: at most %d outputs per render.\n", GENERATOR_MAX_SINKS);
+        return false;
+    }
+    for (int i = 0; i < sink_count; i++) {
+        if (!sinks[i].output) return false;
+    }
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    GeneratorContext local;
+    if (!ctx) {
+        if (!GeneratorContext_init(&local)) return false;
+        ctx = &local;
+    }
+
+    bool success = _sample(ctx, img, &ctx->grid, cfg);
+
+    SinkJob jobs[GENERATOR_MAX_SINKS];
+    pthread_t workers[GENERATOR_MAX_SINKS];
+    bool started[GENERATOR_MAX_SINKS] = { false };
+    RenderStats sink_stats[GENERATOR_MAX_SINKS];
+
+    for (int i = 0; success && i < sink_count; i++) {
+        Stats_reset(&sink_stats[i]);
+        jobs[i] = (SinkJob){
+            .writer = GeneratorContext_writer(ctx, i),
+            .grid = &ctx->grid,
+            .sink = &sinks[i],
+            .stats = cfg->stats ? &sink_stats[i] : NULL,
+            .success = false,
+        };
+        if (!jobs[i].writer)
+            success = false;
+    }
+
+    if (success) {
+        for (int i = 1; i < sink_count; i++)
+            started[i] = pthread_create(&workers[i], NULL, _encodeSink, &jobs[i]) == 0;
+
+        // the calling thread takes the first sink plus any sink a thread failed to start for
+        _encodeSink(&jobs[0]);
+        for (int i = 1; i < sink_count; i++) {
+            if (!started[i])
+                _encodeSink(&jobs[i]);
+        }
+
+        for (int i = 0; i < sink_count; i++) {
+            if (started[i])
+                pthread_join(workers[i], NULL);
+            success = success && jobs[i].success;
+            Stats_merge(cfg->stats, &sink_stats[i]);
+        }
+    }
+
+    if (ctx == &local)
+        GeneratorContext_release(&local);
+
+    return success;
+}
+
+void Generator_computeGridSize(Image* img, const ASCIIGenConfig* config, int* columns, int* rows) {
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    int width = img->width;
+    int height = img->height;
+    if (_hasCrop(cfg) && Image_rectInside(cfg->crop, width, height)) {
+        width = cfg->crop.width;
+        height = cfg->crop.height;
+    }
+
+    float scale_x, scale_y;
+    _computeASCIIDims(width, height, cfg, columns, rows, &scale_x, &scale_y);
+}
+
+size_t Generator_queryOutputSize(const ASCIIGenConfig* config, int columns, int rows) {
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    return Encoder_maxOutputSize(cfg->output_format, cfg->color_mode, columns, rows, _maxGlyphLength(cfg->glyph_mode));
+}
+
+bool Generator_generateASCIIFromImage(Image* img, FILE* output, const ASCIIGenConfig* config) {
+    if (!img || !output) return false;
+
+    GeneratorContext ctx;
+    if (!GeneratorContext_init(&ctx)) return false;
+
+    bool success = Generator_generateASCIIWithContext(&ctx, img, output, config);
+
+    GeneratorContext_release(&ctx);
+
+    return success;
+}
+
+Image* Generator_generateImageFromImage(Image* img, const ASCIIGenConfig* config) {
+    if (!img) return NULL;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    GeneratorContext ctx;
+    if (!GeneratorContext_init(&ctx)) return NULL;
+
+    Image* raster = _generateImage(&ctx, img, cfg);
+
+    GeneratorContext_release(&ctx);
+
+    return raster;
+}
+
 bool Generator_generateACIIFromFile(const char* input_path, const char* output_path, const ASCIIGenConfig* config) {
     if (!input_path || !output_path) return false;
+    RenderStats* stats = config ? config->stats : NULL;
+    StatsTimer timer = { 0 };
 
-    Image* img = Image_load(input_path);
+    Stats_begin(stats, &timer);
+    Image* img = Image_loadAs(input_path, config ? config->layout : DEFAULT_CONFIG.layout);
     if (!img) return false;
+    Stats_end(stats, &timer, STAGE_DECODE, img->size);
+
+    if (config && config->output_format == FORMAT_PNG) {
+        Image* raster = Generator_generateImageFromImage(img, config);
+        Image_free(img);
+        free(img);
+        if (!raster) return false;
+
+        // Image_save picks the encoder from the extension, this always writes PNG
+        Stats_begin(stats, &timer);
+        FILE* out = fopen(output_path, "wb");
+        bool success = out && Image_writePNG(raster, out);
+        if (out && fclose(out) != 0) success = false;
+        Stats_end(stats, &timer, STAGE_ENCODE, (uint64_t)raster->width * raster->height * raster->channels);
+        Image_free(raster);
+        free(raster);
+
+        if (!success) fprintf(stderr, "Generator: cannot write %s.\n", output_path);
+        return success;
+    }
 
     FILE* out = fopen(output_path, "w");
     if (!out) {
         Image_free(img);
+        free(img);
         return false;
     }
 
@@ -286,6 +1397,223 @@ bool Generator_generateACIIFromFile(const char* input_path, const char* output_p
 
     fclose(out);
     Image_free(img);
+    free(img);
+
+    return success;
+}
+
+bool Generator_generateMultiFromFile(const char* input_path,
+                                     const char* const* output_paths, const OutputFormat* formats,
+                                     const bool* plain, int count, const ASCIIGenConfig* config) {
+    if (!input_path || !output_paths || !formats || count <= 0 || count > GENERATOR_MAX_SINKS) return false;
+
+    GeneratorSink sinks[GENERATOR_MAX_SINKS];
+    int opened = 0;
+    bool success = true;
+
+    for (; opened < count; opened++) {
+        sinks[opened] = (GeneratorSink){
+            .format = formats[opened],
+            .output = fopen(output_paths[opened], "wb"),
+            .plain = plain ? plain[opened] : false,
+        };
+        if (!sinks[opened].output) {
+            fprintf(stderr, "Generator: cannot open %s for writing.\n", output_paths[opened]);
+            success = false;
+            break;
+        }
+    }
+
+    if (success) {
+        RenderStats* stats = config ? config->stats : NULL;
+        StatsTimer timer = { 0 };
+
+        Stats_begin(stats, &timer);
+        Image* img = Image_loadAs(input_path, config ? config->layout : DEFAULT_CONFIG.layout);
+        if (img) Stats_end(stats, &timer, STAGE_DECODE, img->size);
+
+        success = img && Generator_generateMulti(NULL, img, sinks, count, config);
+        if (img) {
+            Image_free(img);
+            free(img);
+        }
+    }
+
+    for (int i = 0; i < opened; i++) {
+        if (fclose(sinks[i].output) != 0)
+            success = false;
+    }
+
+    return success;
+}
+
+// Everything besides the input bytes that selects the output, with no padding
+// left uninitialized so it can be hashed as raw bytes
+typedef struct CacheVariant {
+    uint32_t version;
+    uint32_t aspect_bits;
+    uint32_t use_average_pooling;
+    uint32_t grayscale_method;
+    uint32_t color_mode;
+    uint32_t dither_mode;
+    uint32_t edge_mode;
+    uint32_t glyph_mode;
+    uint32_t output_format;
+    int32_t columns;
+    int32_t rows;
+    uint32_t fixed_point;
+    uint32_t linear_light;
+    uint32_t sampling;
+    int32_t crop_x;
+    int32_t crop_y;
+    int32_t crop_width;
+    int32_t crop_height;
+} CacheVariant;
+
+static inline CacheKey _cacheKey(const unsigned char* bytes, size_t length,
+                                 const ASCIIGenConfig* cfg, int columns, int rows) {
+    CacheVariant variant;
+    memset(&variant, 0, sizeof(variant));
+
+    variant.version = GENERATOR_CACHE_VERSION;
+    memcpy(&variant.aspect_bits, &cfg->terminal_aspect_ratio, sizeof(variant.aspect_bits));
+    variant.use_average_pooling = cfg->use_average_pooling;
+    variant.grayscale_method = cfg->grayscale_method;
+    variant.color_mode = cfg->color_mode;
+    variant.dither_mode = cfg->dither_mode;
+    variant.edge_mode = cfg->edge_mode;
+    variant.glyph_mode = cfg->glyph_mode;
+    variant.output_format = cfg->output_format;
+    variant.columns = columns;
+    variant.rows = rows;
+    variant.fixed_point = cfg->fixed_point;
+    variant.linear_light = cfg->linear_light;
+    variant.sampling = cfg->sampling;
+    variant.crop_x = cfg->crop.x;
+    variant.crop_y = cfg->crop.y;
+    variant.crop_width = cfg->crop.width;
+    variant.crop_height = cfg->crop.height;
+
+    CacheKey key;
+    key.content = Cache_hash(bytes, length, 0);
+    key.variant = Cache_hash(&variant, sizeof(variant), key.content);
+    key.variant = Cache_hash(cfg->char_set, strlen(cfg->char_set), key.variant);
+
+    return key;
+}
+
+bool Generator_computeCacheKey(const unsigned char* bytes, size_t length,
+                               const ASCIIGenConfig* config, CacheKey* key) {
+    if (!bytes || !key) return false;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    // the grid only needs the header, so a hit never decodes the pixels
+    Image header = { 0 };
+    if (!Image_readDimensions(bytes, length, &header.width, &header.height))
+        return false;
+    if (_hasCrop(cfg) && !Image_rectInside(cfg->crop, header.width, header.height)) {
+        fprintf(stderr, "Generator: crop %dx%d at %d,%d is not inside the %dx%d image.\n",
+                cfg->crop.width, cfg->crop.height, cfg->crop.x, cfg->crop.y, header.width, header.height);
+        return false;
+    }
+
+    int columns, rows;
+    Generator_computeGridSize(&header, cfg, &columns, &rows);
+    *key = _cacheKey(bytes, length, cfg, columns, rows);
+
+    return true;
+}
+
+bool Generator_generateCachedFromFile(const char* input_path, const char* output_path,
+                                      const ASCIIGenConfig* config, RenderCache* cache) {
+    if (!cache) return Generator_generateACIIFromFile(input_path, output_path, config);
+    if (!input_path || !output_path) return false;
+    const ASCIIGenConfig* cfg = config ? config : &DEFAULT_CONFIG;
+
+    int in_fd = open(input_path, O_RDONLY);
+    if (in_fd < 0) {
+        fprintf(stderr, "File %s does not exist\n", input_path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(in_fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "Error reading %s\n", input_path);
+        close(in_fd);
+        return false;
+    }
+
+    // hashing and decoding both read the mapping, the file is never copied
+    size_t length = (size_t)st.st_size;
+    unsigned char* bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, in_fd, 0);
+    close(in_fd);
+    if (bytes == MAP_FAILED) {
+        fprintf(stderr, "Error reading %s\n", input_path);
+        return false;
+    }
+
+    StatsTimer timer = { 0 };
+    Stats_begin(cfg->stats, &timer);
+
+    CacheKey key;
+    if (!Generator_computeCacheKey(bytes, length, cfg, &key)) {
+        fprintf(stderr, "Error loading image %s\n", input_path);
+        munmap(bytes, length);
+        return false;
+    }
+
+    int out_fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        munmap(bytes, length);
+        return false;
+    }
+
+    bool hit = Cache_fetch(cache, &key, out_fd);
+    Stats_end(cfg->stats, &timer, STAGE_CACHE, length);
+
+    if (hit) {
+        munmap(bytes, length);
+        return close(out_fd) == 0;
+    }
+
+    bool success = false;
+    Stats_begin(cfg->stats, &timer);
+    Image* img = Image_loadFromMemoryAs(bytes, length, cfg->layout);
+    if (img) Stats_end(cfg->stats, &timer, STAGE_DECODE, img->size);
+    munmap(bytes, length);
+
+    if (img) {
+        if (cfg->output_format == FORMAT_PNG) {
+            // Image_save picks the encoder from the extension, this always writes PNG
+            Image* raster = Generator_generateImageFromImage(img, cfg);
+            FILE* out = raster ? fdopen(dup(out_fd), "wb") : NULL;
+
+            Stats_begin(cfg->stats, &timer);
+            success = out && Image_writePNG(raster, out);
+            if (out && fclose(out) != 0) success = false;
+            if (raster) Stats_end(cfg->stats, &timer, STAGE_ENCODE, (uint64_t)raster->width * raster->height * raster->channels);
+
+            if (raster) {
+                Image_free(raster);
+                free(raster);
+            }
+        } else {
+            FILE* out = fdopen(dup(out_fd), "wb");
+            success = out && Generator_generateASCIIFromImage(img, out, cfg);
+            if (out && fclose(out) != 0) success = false;
+        }
+        Image_free(img);
+        free(img);
+    }
+
+    // a failed store only costs a future re-render
+    if (success) {
+        Stats_begin(cfg->stats, &timer);
+        Cache_store(cache, &key, out_fd);
+        Stats_end(cfg->stats, &timer, STAGE_CACHE, 0);
+    }
+
+    if (close(out_fd) != 0) success = false;
 
     return success;
 }
@@ -5,11 +5,22 @@
 #include <string.h>
 #include <limits.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 
+#include "Resample.h"
 #include "Dithering.h"
+#include "Encoder.h"
+#include "Gamma.h"
+#include "Grid.h"
+#include "Output.h"
+#include "Raster.h"
+#include "ShapeMatch.h"
 #include "Sobel.h"
+#include "Subpixel.h"
+#include "../Cache/Cache.h"
 #include "../Image/Image.h"
+#include "../Stats/Stats.h"
 
 typedef enum EdgeMode {
     EDGE_NONE,
@@ -21,12 +32,19 @@ typedef enum DitherMode {
     DITHER_FLOYD_STEINBERG
 } DitherMode;
 
-typedef enum ColorMode {
-    COLOR_NONE,
-    COLOR_16,
-    COLOR_256,
-    COLOR_TRUE
-} ColorMode;
+typedef enum SamplingMode {
+    SAMPLING_BLOCK,     // cells snap to whole pixels
+    SAMPLING_AREA,      // pixels on cell edges count by the part the cell covers
+    SAMPLING_TRIANGLE,  // tent filter over the neighboring cells, smoother ramps
+    SAMPLING_LANCZOS    // Lanczos-3 filter, sharpest edges without aliasing
+} SamplingMode;
+
+typedef enum GlyphMode {
+    GLYPH_BRIGHTNESS,
+    GLYPH_BRAILLE,
+    GLYPH_SEXTANT,
+    GLYPH_SHAPE
+} GlyphMode;
 
 typedef struct ASCIIGenConfig {
     const char* char_set;
@@ -36,16 +54,114 @@ typedef struct ASCIIGenConfig {
     ColorMode color_mode;
     DitherMode dither_mode;
     EdgeMode edge_mode;
+    GlyphMode glyph_mode;
+    OutputFormat output_format;
+    bool fixed_point;   // integer-only sampling (16.16 cell means, integer luminance and
+                        // error diffusion), bit-identical on every compiler and CPU
+    bool linear_light;  // average cells in linear light instead of gamma-encoded sRGB
+    SamplingMode sampling;
+    ImageLayout layout;     // how loaders decode, planar splits color images into one plane per channel
+    ImageRect crop;         // render only this block of the image, width and height 0 render all of it
+    int columns;    // grid size in cells; 0 fits the terminal, or follows the
+    int rows;       // aspect ratio when only the other one is set
+    int threads;    // tile workers of one render, caller included: 0 for one per CPU, 1 runs
+                    // every stage on the calling thread; the output does not depend on it
+    RenderStats* stats;     // optional, every render with this config adds its stage timings
 } ASCIIGenConfig;
 
 extern const ASCIIGenConfig DEFAULT_CONFIG;
 
+// Most outputs a single multi-format render can write
+#define GENERATOR_MAX_SINKS 8
+
+// One output of a multi-format render
+typedef struct GeneratorSink {
+    OutputFormat format;
+    FILE* output;       // every sink needs its own FILE, they are written concurrently
+    bool plain;         // drop colors (e.g. plain text next to the ANSI output)
+} GeneratorSink;
+
+// Reusable scratch memory for repeated generation (batch, video, servers).
+// A context must not be used by two threads at the same time.
+typedef struct GeneratorContext GeneratorContext;
+
+GeneratorContext* GeneratorContext_create(void);
+void GeneratorContext_free(GeneratorContext* ctx);
+
 // Generate ASCII from an already loaded image
 // - Does NOT take ownership of `img`, so the caller must free it.
 // - Writes output ti given FILE*
 bool Generator_generateASCIIFromImage(Image* img, FILE* output, const ASCIIGenConfig* config);
 
+// Same as Generator_generateASCIIFromImage, but all scratch memory comes from
+// `ctx`, so once it has seen the largest job repeated calls do not allocate
+bool Generator_generateASCIIWithContext(GeneratorContext* ctx, Image* img, FILE* output, const ASCIIGenConfig* config);
+
+// Renders into caller-provided memory instead of a FILE*, without copies.
+// - `ctx` may be NULL, in which case a temporary context is used.
+// - `*written` receives the byte count; if it exceeds `capacity` the buffer was
+//   too small, the call fails and `*written` is the exact size required
+//   (like snprintf, `buffer` may be NULL with a capacity of 0).
+// - The output is not NUL-terminated. PNG output is not supported.
+bool Generator_generateASCIIToBuffer(GeneratorContext* ctx, Image* img,
+                                     char* buffer, size_t capacity, size_t* written,
+                                     const ASCIIGenConfig* config);
+
+// Renders into a malloc'd buffer that the caller frees, PNG included.
+// - `ctx` may be NULL, in which case a temporary context is used.
+// - `*length` receives the byte count; returns NULL on failure.
+char* Generator_generateASCIIToMemory(GeneratorContext* ctx, Image* img, size_t* length,
+                                      const ASCIIGenConfig* config);
+
+// Samples `img` into `grid` without encoding it. The grid keeps its storage
+// between calls, so it can be reused; release it with Grid_free.
+// - `ctx` may be NULL, in which case a temporary context is used.
+bool Generator_generateGrid(GeneratorContext* ctx, Image* img, Grid* grid, const ASCIIGenConfig* config);
+
+// Encodes a sampled grid without touching the image again, so one sampling
+// pass can be written out in several formats (`ctx` may be NULL)
+bool Generator_encodeGrid(GeneratorContext* ctx, const Grid* grid, FILE* output, OutputFormat format);
+bool Generator_encodeGridToBuffer(GeneratorContext* ctx, const Grid* grid,
+                                  char* buffer, size_t capacity, size_t* written,
+                                  OutputFormat format);
+
+// Runs decode-independent stages (grayscale, edges, dithering, sampling) once
+// and encodes the resulting grid to every sink, each on its own thread.
+// The sinks share `config`; its output_format is ignored. `ctx` may be NULL.
+bool Generator_generateMulti(GeneratorContext* ctx, Image* img,
+                             const GeneratorSink* sinks, int sink_count,
+                             const ASCIIGenConfig* config);
+
+// Grid (in cells) that `img` (its crop block, if it lies inside) is rendered to with `config`
+void Generator_computeGridSize(Image* img, const ASCIIGenConfig* config, int* columns, int* rows);
+
+// Bytes that are always enough to hold the output of a columns x rows grid
+// rendered with `config`, whatever the image content; 0 for PNG output
+size_t Generator_queryOutputSize(const ASCIIGenConfig* config, int columns, int rows);
+
+// Generates ASCII from an already loaded image and rasterizes it with the embedded font
+// - Does NOT take ownership of `img`; the caller owns the returned image.
+Image* Generator_generateImageFromImage(Image* img, const ASCIIGenConfig* config);
+
 // Loads image, generates ASCII and saves to file
 bool Generator_generateACIIFromFile(const char* input_path, const char* output_path, const ASCIIGenConfig* config);
 
+// Same as Generator_generateACIIFromFile, but looks the result up in `cache`
+// first: a hit copies the stored output without decoding the image, a miss
+// renders normally and stores the output. The key covers the input bytes,
+// every config field and the resolved grid size.
+bool Generator_generateCachedFromFile(const char* input_path, const char* output_path,
+                                      const ASCIIGenConfig* config, RenderCache* cache);
+
+// Computes the cache key of an encoded image rendered with `config`; only
+// the image header is parsed (to resolve the grid size)
+bool Generator_computeCacheKey(const unsigned char* bytes, size_t length,
+                               const ASCIIGenConfig* config, CacheKey* key);
+
+// Loads image once and writes it to every path in the matching format;
+// outputs marked in `plain` (NULL for none) are written without colors
+bool Generator_generateMultiFromFile(const char* input_path,
+                                     const char* const* output_paths, const OutputFormat* formats,
+                                     const bool* plain, int count, const ASCIIGenConfig* config);
+
 #endif // GENERATOR_H
@@ -0,0 +1,114 @@
+#include "GeneratorContext.h"
+
+static bool _writerInit(GeneratorWriter* writer) {
+    Arena_init(&writer->arena, 0);
+    Encoder_init(&writer->encoder);
+
+    if (!Output_initFile(&writer->output, NULL) || !Output_initMemory(&writer->text))
+        return false;
+
+    writer->ready = true;
+    return true;
+}
+
+static void _writerRelease(GeneratorWriter* writer) {
+    Arena_release(&writer->arena);
+    free(writer->output.data);
+    free(writer->text.data);
+    Encoder_free(&writer->encoder);
+
+    memset(writer, 0, sizeof(GeneratorWriter));
+}
+
+bool GeneratorContext_init(GeneratorContext* ctx) {
+    memset(ctx, 0, sizeof(GeneratorContext));
+    Arena_init(&ctx->arena, 0);
+    Grid_init(&ctx->grid);
+
+    if (!GeneratorContext_writer(ctx, 0)) {
+        GeneratorContext_release(ctx);
+        return false;
+    }
+
+    return true;
+}
+
+void GeneratorContext_release(GeneratorContext* ctx) {
+    Arena_release(&ctx->arena);
+    Grid_free(&ctx->grid);
+    for (int i = 0; i < GENERATOR_MAX_SINKS; i++)
+        _writerRelease(&ctx->writers[i]);
+    ShapeMatch_free(ctx->matcher);
+    free(ctx->matcher_char_set);
+    Tiles_destroy(&ctx->tiles);
+
+    memset(ctx, 0, sizeof(GeneratorContext));
+}
+
+GeneratorWriter* GeneratorContext_writer(GeneratorContext* ctx, int index) {
+    if (index < 0 || index >= GENERATOR_MAX_SINKS) return NULL;
+
+    GeneratorWriter* writer = &ctx->writers[index];
+    if (!writer->ready && !_writerInit(writer)) {
+        _writerRelease(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+GeneratorContext* GeneratorContext_create(void) {
+    Stats_countAllocations(1);
+    GeneratorContext* ctx = malloc(sizeof(GeneratorContext));
+    if (!ctx) {
+        fprintf(stderr, "GeneratorContext: failed to allocate context.\n");
+        return NULL;
+    }
+
+    if (!GeneratorContext_init(ctx)) {
+        free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void GeneratorContext_free(GeneratorContext* ctx) {
+    if (!ctx) return;
+
+    GeneratorContext_release(ctx);
+    free(ctx);
+}
+
+TilePool* GeneratorContext_tilePool(GeneratorContext* ctx, int threads) {
+    if (threads == 1) return NULL;
+
+    if (!ctx->tiles.ready || ctx->tile_threads != threads) {
+        Tiles_destroy(&ctx->tiles);
+        Tiles_init(&ctx->tiles, threads);
+        ctx->tile_threads = threads;
+    }
+
+    return &ctx->tiles;
+}
+
+const ShapeMatcher* GeneratorContext_shapeMatcher(GeneratorContext* ctx, const char* char_set) {
+    if (ctx->matcher && strcmp(ctx->matcher_char_set, char_set) == 0)
+        return ctx->matcher;
+
+    ShapeMatch_free(ctx->matcher);
+    free(ctx->matcher_char_set);
+
+    ctx->matcher = ShapeMatch_create(char_set);
+    Stats_countAllocations(1);
+    ctx->matcher_char_set = strdup(char_set);
+
+    if (!ctx->matcher || !ctx->matcher_char_set) {
+        ShapeMatch_free(ctx->matcher);
+        free(ctx->matcher_char_set);
+        ctx->matcher = NULL;
+        ctx->matcher_char_set = NULL;
+    }
+
+    return ctx->matcher;
+}
@@ -0,0 +1,54 @@
+#ifndef GENERATORCONTEXT_H
+#define GENERATORCONTEXT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "Generator.h"
+#include "../Arena/Arena.h"
+#include "../Tiles/Tiles.h"
+
+// Encoding state of one output. Each sink of a multi-format render gets its
+// own writer, so the sinks can be encoded on separate threads.
+typedef struct GeneratorWriter {
+    OutputBuffer output;              // rebound to the output FILE of each call
+    OutputBuffer text;                // in-memory text for the raster output
+    Encoder encoder;
+    Arena arena;                      // raster cells and glyph atlas
+    bool ready;
+} GeneratorWriter;
+
+// Memory of the generator kept between calls. Per-render temporaries come
+// from `arena`, which is reset at the start of every render and settles on a
+// single block sized for the largest job, so repeated renders stop allocating.
+// Only the generator sees the layout; users get the opaque typedef from Generator.h.
+struct GeneratorContext {
+    Arena arena;                      // grayscale copy, edge and dither scratch
+    Grid grid;                        // cells of the current render
+
+    // writers[0] serves single-output calls, the others are set up on first use
+    GeneratorWriter writers[GENERATOR_MAX_SINKS];
+
+    ShapeMatcher* matcher;            // built for `matcher_char_set`
+    char* matcher_char_set;
+
+    TilePool tiles;                   // started for `tile_threads` on the first multi-threaded render
+    int tile_threads;
+};
+
+bool GeneratorContext_init(GeneratorContext* ctx);
+void GeneratorContext_release(GeneratorContext* ctx);
+
+// Returns writer `index`, initializing it on first use (NULL on failure)
+GeneratorWriter* GeneratorContext_writer(GeneratorContext* ctx, int index);
+
+// Returns the pool for `threads` tile workers (0 for one per CPU), restarted
+// only when the count changes; NULL for 1, which runs tiles inline
+TilePool* GeneratorContext_tilePool(GeneratorContext* ctx, int threads);
+
+// Returns a matcher for `char_set`, rebuilt only when the charset changes
+const ShapeMatcher* GeneratorContext_shapeMatcher(GeneratorContext* ctx, const char* char_set);
+
+#endif // GENERATORCONTEXT_H
@@ -0,0 +1,101 @@
+#include "Grid.h"
+
+#define BYTE(i)       { { (i) }, 1 }
+#define BYTE4(i)      BYTE(i), BYTE((i) + 1), BYTE((i) + 2), BYTE((i) + 3)
+#define BYTE16(i)     BYTE4(i), BYTE4((i) + 4), BYTE4((i) + 8), BYTE4((i) + 12)
+#define BYTE64(i)     BYTE16(i), BYTE16((i) + 16), BYTE16((i) + 32), BYTE16((i) + 48)
+
+// Cells whose palette indices Grid_encode computes in one kernel call
+#define GRID_ENCODE_CHUNK 256
+
+const UTF8Glyph GRID_BYTE_GLYPHS[256] = {
+    BYTE64(0), BYTE64(64), BYTE64(128), BYTE64(192)
+};
+
+void Grid_init(Grid* grid) {
+    memset(grid, 0, sizeof(Grid));
+    grid->glyph_table = GRID_BYTE_GLYPHS;
+    grid->cell_aspect_ratio = 2.0f;
+}
+
+static inline void _assignPlanes(Grid* grid, size_t cells) {
+    grid->glyphs = grid->data;
+    grid->r = grid->data + cells;
+    grid->g = grid->data + 2 * cells;
+    grid->b = grid->data + 3 * cells;
+}
+
+bool Grid_resize(Grid* grid, int columns, int rows) {
+    if (columns <= 0 || rows <= 0) {
+        fprintf(stderr, "Grid: invalid size %dx%d.\n", columns, rows);
+        return false;
+    }
+
+    size_t cells = (size_t)columns * rows;
+    if (cells > SIZE_MAX / 4) {
+        fprintf(stderr, "Grid: %dx%d cells do not fit in memory.\n", columns, rows);
+        return false;
+    }
+
+    if (cells > grid->capacity) {
+        Stats_countAllocations(1);
+        unsigned char* data = realloc(grid->data, cells * 4);
+        if (!data) {
+            fprintf(stderr, "Grid: failed to allocate %zu cells.\n", cells);
+            return false;
+        }
+
+        grid->data = data;
+        grid->capacity = cells;
+    }
+
+    grid->columns = columns;
+    grid->rows = rows;
+    _assignPlanes(grid, cells);
+
+    return true;
+}
+
+void Grid_free(Grid* grid) {
+    free(grid->data);
+    Grid_init(grid);
+}
+
+bool Grid_encode(const Grid* grid, Encoder* encoder, OutputBuffer* out, OutputFormat format) {
+    if (!Encoder_begin(encoder, out, format, grid->color_mode, grid->columns, grid->rows))
+        return false;
+
+    const Kernels* kernels = Kernels_get();
+    void (*quantize)(const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, size_t) =
+        (grid->color_mode == COLOR_16)  ? kernels->quantize16 :
+        (grid->color_mode == COLOR_256) ? kernels->quantize256 : NULL;
+
+    unsigned char palette[GRID_ENCODE_CHUNK];
+
+    size_t i = 0;
+    for (int y = 0; y < grid->rows; y++) {
+        if (!quantize) {
+            for (int x = 0; x < grid->columns; x++, i++) {
+                const UTF8Glyph* glyph = &grid->glyph_table[grid->glyphs[i]];
+                Encoder_putCell(encoder, (const char*)glyph->bytes, glyph->length,
+                                grid->r[i], grid->g[i], grid->b[i]);
+            }
+        } else {
+            // palette indices for a run of cells at a time, then the cells
+            for (int x = 0; x < grid->columns; ) {
+                int run = grid->columns - x;
+                if (run > GRID_ENCODE_CHUNK) run = GRID_ENCODE_CHUNK;
+
+                quantize(grid->r + i, grid->g + i, grid->b + i, palette, (size_t)run);
+                for (int k = 0; k < run; k++, i++) {
+                    const UTF8Glyph* glyph = &grid->glyph_table[grid->glyphs[i]];
+                    Encoder_putPaletteCell(encoder, (const char*)glyph->bytes, glyph->length, palette[k]);
+                }
+                x += run;
+            }
+        }
+        Encoder_endRow(encoder);
+    }
+
+    return Encoder_end(encoder);
+}
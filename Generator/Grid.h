@@ -0,0 +1,53 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "Encoder.h"
+#include "Output.h"
+#include "Subpixel.h"
+
+// Sampled cells of one render, before any encoding.
+// The four per-cell arrays are packed back to back in a single allocation:
+// glyph indices first, then the red, green and blue planes, all row-major.
+// A glyph index is looked up in `glyph_table` to get its UTF-8 bytes, so a
+// grid can be cached, diffed or encoded again without the source image.
+typedef struct Grid {
+    int columns;
+    int rows;
+    ColorMode color_mode;            // mode the cells were sampled for; colors are 0 for COLOR_NONE
+    float cell_aspect_ratio;         // terminal_aspect_ratio the grid was sized with
+    const UTF8Glyph* glyph_table;    // GRID_BYTE_GLYPHS or one of the SUBPIXEL tables
+
+    unsigned char* glyphs;
+    unsigned char* r;
+    unsigned char* g;
+    unsigned char* b;
+
+    unsigned char* data;             // backing memory of the four arrays
+    size_t capacity;                 // cells `data` can hold
+} Grid;
+
+// Byte i maps to the one-byte glyph i; used by the charset based glyph modes
+extern const UTF8Glyph GRID_BYTE_GLYPHS[256];
+
+// `grid` starts empty; storage is only allocated by Grid_resize
+void Grid_init(Grid* grid);
+
+// Sets the grid size, growing the storage only when it is too small
+bool Grid_resize(Grid* grid, int columns, int rows);
+
+void Grid_free(Grid* grid);
+
+static inline size_t Grid_cellCount(const Grid* grid) {
+    return (size_t)grid->columns * grid->rows;
+}
+
+// Streams every cell of `grid` through `encoder` as `format` into `out`
+bool Grid_encode(const Grid* grid, Encoder* encoder, OutputBuffer* out, OutputFormat format);
+
+#endif // GRID_H
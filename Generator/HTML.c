@@ -0,0 +1,272 @@
+#include "HTML.h"
+
+#define HTML_PALETTE_EMPTY      0xFFFFFFFFu
+#define HTML_PALETTE_MIN_SLOTS  256
+
+#define LITERAL(out, str)       Output_write((out), (str), sizeof(str) - 1)
+
+static const char HTML_HEAD[] =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "<meta charset=\"utf-8\">\n"
+    "<title>genSCII</title>\n"
+    "<style>\n";
+static const char HTML_STYLE_COLORED[] = "pre{background:#000;color:#fff;font-family:monospace;line-height:1}\n";
+static const char HTML_STYLE_PLAIN[]   = "pre{background:#fff;color:#000;font-family:monospace;line-height:1}\n";
+static const char HTML_BODY[] =
+    "</style>\n"
+    "</head>\n"
+    "<body>\n"
+    "<pre>";
+static const char HTML_PRE_END[]     = "</pre>\n";
+static const char HTML_PALETTE_BEGIN[] = "<style>\n";
+static const char HTML_PALETTE_END[] = "</style>\n";
+static const char HTML_TAIL[]        = "</body>\n</html>\n";
+static const char HTML_SPAN_OPEN[]   = "<span class=\"";
+static const char HTML_SPAN_CLASS_END[] = "\">";
+static const char HTML_SPAN_CLOSE[]  = "</span>";
+static const char HTML_RULE_OPEN[]   = "{color:";
+static const char HTML_RULE_CLOSE[]  = "}\n";
+
+// longest escaped single-byte glyph (&amp;)
+#define HTML_MAX_ESCAPE 5
+
+// Slot of `color` in a table of `capacity` (a power of two) slots
+static inline size_t _hashColor(uint32_t color, size_t capacity) {
+    // Fibonacci hashing: the top bits of the product depend on every channel,
+    // the low bits only on blue and green
+    int bits = __builtin_ctzll(capacity);
+    return (size_t)((uint32_t)(color * 2654435769u) >> (32 - bits));
+}
+
+static bool _paletteInit(HTMLPalette* palette) {
+    // reuse the table of a previous document
+    if (palette->keys) {
+        memset(palette->keys, 0xFF, palette->capacity * sizeof(uint32_t));
+        palette->count = 0;
+        return true;
+    }
+
+    palette->capacity = HTML_PALETTE_MIN_SLOTS;
+    palette->count = 0;
+    Stats_countAllocations(3);
+    palette->keys = malloc(palette->capacity * sizeof(uint32_t));
+    palette->ids = malloc(palette->capacity * sizeof(uint32_t));
+    palette->colors = malloc((palette->capacity / 2) * sizeof(uint32_t));
+
+    if (!palette->keys || !palette->ids || !palette->colors) {
+        fprintf(stderr, "HTML: failed to allocate color palette.\n");
+        free(palette->keys);
+        free(palette->ids);
+        free(palette->colors);
+        palette->keys = palette->ids = palette->colors = NULL;
+        return false;
+    }
+
+    memset(palette->keys, 0xFF, palette->capacity * sizeof(uint32_t));
+    return true;
+}
+
+static void _paletteFree(HTMLPalette* palette) {
+    free(palette->keys);
+    free(palette->ids);
+    free(palette->colors);
+    palette->keys = palette->ids = palette->colors = NULL;
+    palette->capacity = palette->count = 0;
+}
+
+static bool _paletteGrow(HTMLPalette* palette) {
+    size_t capacity = palette->capacity * 2;
+    Stats_countAllocations(3);
+    uint32_t* keys = malloc(capacity * sizeof(uint32_t));
+    uint32_t* ids = malloc(capacity * sizeof(uint32_t));
+    uint32_t* colors = realloc(palette->colors, (capacity / 2) * sizeof(uint32_t));
+
+    if (!keys || !ids || !colors) {
+        fprintf(stderr, "HTML: failed to grow color palette.\n");
+        free(keys);
+        free(ids);
+        if (colors) palette->colors = colors;
+        return false;
+    }
+
+    memset(keys, 0xFF, capacity * sizeof(uint32_t));
+
+    // colors[] already lists every key, so rehash from it
+    for (size_t id = 0; id < palette->count; id++) {
+        size_t slot = _hashColor(colors[id], capacity);
+        while (keys[slot] != HTML_PALETTE_EMPTY)
+            slot = (slot + 1) & (capacity - 1);
+        keys[slot] = colors[id];
+        ids[slot] = (uint32_t)id;
+    }
+
+    free(palette->keys);
+    free(palette->ids);
+    palette->keys = keys;
+    palette->ids = ids;
+    palette->colors = colors;
+    palette->capacity = capacity;
+
+    return true;
+}
+
+// Returns the class id of `color`, registering it on first use
+static uint32_t _paletteLookup(HTMLPalette* palette, uint32_t color) {
+    size_t mask = palette->capacity - 1;
+    size_t slot = _hashColor(color, palette->capacity);
+
+    while (palette->keys[slot] != HTML_PALETTE_EMPTY) {
+        if (palette->keys[slot] == color)
+            return palette->ids[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    // keep the load factor at or below 1/2
+    if ((palette->count + 1) * 2 > palette->capacity) {
+        if (!_paletteGrow(palette))
+            return 0;
+        return _paletteLookup(palette, color);
+    }
+
+    uint32_t id = (uint32_t)palette->count++;
+    palette->keys[slot] = color;
+    palette->ids[slot] = id;
+    palette->colors[id] = color;
+
+    return id;
+}
+
+static inline void _writeClassName(OutputBuffer* out, uint32_t id) {
+    static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    char name[8];
+    int len = 0;
+    do {
+        name[len++] = DIGITS[id % 36];
+        id /= 36;
+    } while (id > 0);
+
+    Output_putc(out, 'c');
+    while (len > 0)
+        Output_putc(out, name[--len]);
+}
+
+static inline void _closeSpan(HTMLWriter* writer) {
+    if (writer->span_open) {
+        LITERAL(writer->out, HTML_SPAN_CLOSE);
+        writer->span_open = false;
+    }
+}
+
+bool HTML_begin(HTMLWriter* writer, OutputBuffer* out, bool colored) {
+    writer->out = out;
+    writer->colored = colored;
+    writer->span_open = false;
+    writer->span_color = 0;
+
+    if (colored && !_paletteInit(&writer->palette))
+        return false;
+
+    LITERAL(out, HTML_HEAD);
+    if (colored)
+        LITERAL(out, HTML_STYLE_COLORED);
+    else
+        LITERAL(out, HTML_STYLE_PLAIN);
+    LITERAL(out, HTML_BODY);
+
+    return true;
+}
+
+void HTML_putCell(HTMLWriter* writer, const char* glyph, size_t glyph_length, uint32_t color) {
+    OutputBuffer* out = writer->out;
+
+    if (writer->colored && (!writer->span_open || writer->span_color != color)) {
+        _closeSpan(writer);
+
+        LITERAL(out, HTML_SPAN_OPEN);
+        _writeClassName(out, _paletteLookup(&writer->palette, color));
+        LITERAL(out, HTML_SPAN_CLASS_END);
+
+        writer->span_open = true;
+        writer->span_color = color;
+    }
+
+    if (glyph_length == 1) {
+        switch (glyph[0]) {
+            case '<': Output_write(out, "&lt;", 4);  return;
+            case '>': Output_write(out, "&gt;", 4);  return;
+            case '&': Output_write(out, "&amp;", 5); return;
+        }
+    }
+
+    Output_write(out, glyph, glyph_length);
+}
+
+void HTML_endRow(HTMLWriter* writer) {
+    // spans may run across rows, <pre> keeps the line break either way
+    Output_putc(writer->out, '\n');
+}
+
+bool HTML_end(HTMLWriter* writer) {
+    OutputBuffer* out = writer->out;
+
+    _closeSpan(writer);
+    LITERAL(out, HTML_PRE_END);
+
+    // the palette is only known once every cell has been streamed
+    if (writer->colored) {
+        LITERAL(out, HTML_PALETTE_BEGIN);
+        for (size_t id = 0; id < writer->palette.count; id++) {
+            Output_putc(out, '.');
+            _writeClassName(out, (uint32_t)id);
+            LITERAL(out, HTML_RULE_OPEN);
+            Output_writeHexColor(out, writer->palette.colors[id]);
+            LITERAL(out, HTML_RULE_CLOSE);
+        }
+        LITERAL(out, HTML_PALETTE_END);
+    }
+
+    LITERAL(out, HTML_TAIL);
+
+    return !out->failed;
+}
+
+void HTML_free(HTMLWriter* writer) {
+    _paletteFree(&writer->palette);
+}
+
+static inline size_t _classNameLength(size_t id) {
+    size_t len = 2;    // 'c' plus the first digit
+    while (id >= 36) {
+        id /= 36;
+        len++;
+    }
+    return len;
+}
+
+size_t HTML_maxOutputSize(bool colored, size_t columns, size_t rows, size_t max_glyph_length, size_t max_colors) {
+    size_t cells = columns * rows;
+    size_t glyph = (max_glyph_length > HTML_MAX_ESCAPE) ? max_glyph_length : HTML_MAX_ESCAPE;
+
+    size_t size = sizeof(HTML_HEAD) - 1
+                + (colored ? sizeof(HTML_STYLE_COLORED) : sizeof(HTML_STYLE_PLAIN)) - 1
+                + sizeof(HTML_BODY) - 1
+                + sizeof(HTML_PRE_END) - 1
+                + sizeof(HTML_TAIL) - 1
+                + rows
+                + cells * glyph;
+
+    if (colored && cells > 0) {
+        if (max_colors > cells) max_colors = cells;
+        size_t name = _classNameLength(max_colors - 1);
+
+        // worst case: every cell opens its own span
+        size += cells * (sizeof(HTML_SPAN_OPEN) - 1 + name + sizeof(HTML_SPAN_CLASS_END) - 1 + sizeof(HTML_SPAN_CLOSE) - 1);
+        size += sizeof(HTML_PALETTE_BEGIN) - 1 + sizeof(HTML_PALETTE_END) - 1;
+        size += max_colors * (1 + name + sizeof(HTML_RULE_OPEN) - 1 + 7 + sizeof(HTML_RULE_CLOSE) - 1);
+    }
+
+    return size;
+}
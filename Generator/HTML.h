@@ -0,0 +1,42 @@
+#ifndef HTML_H
+#define HTML_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "Output.h"
+
+// Colors are packed as 0xRRGGBB
+typedef struct HTMLPalette {
+    uint32_t* keys;      // open addressing table, HTML_PALETTE_EMPTY marks free slots
+    uint32_t* ids;
+    uint32_t* colors;    // colors in class id order
+    size_t capacity;     // table slots (power of two)
+    size_t count;
+} HTMLPalette;
+
+// Streams a <pre> document: adjacent cells with the same color share one <span>
+// and every distinct color becomes a CSS class, declared once at the end
+typedef struct HTMLWriter {
+    OutputBuffer* out;
+    bool colored;
+    bool span_open;
+    uint32_t span_color;
+    HTMLPalette palette;
+} HTMLWriter;
+
+// `writer` must be zeroed before its first use; the palette is kept across
+// documents and only released by HTML_free
+bool HTML_begin(HTMLWriter* writer, OutputBuffer* out, bool colored);
+void HTML_putCell(HTMLWriter* writer, const char* glyph, size_t glyph_length, uint32_t color);
+void HTML_endRow(HTMLWriter* writer);
+bool HTML_end(HTMLWriter* writer);
+void HTML_free(HTMLWriter* writer);
+
+// Upper bound of the document size for a grid whose cells use at most
+// `max_colors` distinct colors and `max_glyph_length` bytes per glyph
+size_t HTML_maxOutputSize(bool colored, size_t columns, size_t rows, size_t max_glyph_length, size_t max_colors);
+
+#endif // HTML_H
@@ -0,0 +1,107 @@
+#include "Output.h"
+
+bool Output_initFile(OutputBuffer* out, FILE* file) {
+    out->file = file;
+    out->length = 0;
+    out->capacity = OUTPUT_BUFFER_CAPACITY;
+    out->failed = false;
+    out->fixed = false;
+
+    Stats_countAllocations(1);
+    out->data = malloc(out->capacity);
+    if (!out->data) {
+        fprintf(stderr, "Output: failed to allocate buffer.\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool Output_initMemory(OutputBuffer* out) {
+    return Output_initFile(out, NULL);
+}
+
+void Output_initFixed(OutputBuffer* out, char* data, size_t capacity) {
+    out->file = NULL;
+    out->data = data;
+    out->length = 0;
+    out->capacity = capacity;
+    out->failed = false;
+    out->fixed = true;
+}
+
+void Output_reset(OutputBuffer* out, FILE* file) {
+    out->file = file;
+    out->length = 0;
+    out->failed = false;
+}
+
+bool Output_flush(OutputBuffer* out) {
+    if (!out->file)
+        return !out->failed;
+
+    if (out->length > 0) {
+        if (fwrite(out->data, 1, out->length, out->file) != out->length)
+            out->failed = true;
+    }
+    out->length = 0;
+
+    return !out->failed;
+}
+
+bool Output_free(OutputBuffer* out) {
+    bool ok = Output_flush(out);
+
+    if (!out->fixed)
+        free(out->data);
+    out->data = NULL;
+    out->capacity = 0;
+
+    return ok;
+}
+
+static void _grow(OutputBuffer* out, size_t length) {
+    size_t capacity = out->capacity;
+    while (capacity < out->length + length)
+        capacity *= 2;
+
+    Stats_countAllocations(1);
+    char* data = realloc(out->data, capacity);
+    if (!data) {
+        fprintf(stderr, "Output: failed to grow buffer.\n");
+        out->failed = true;
+        return;
+    }
+
+    out->data = data;
+    out->capacity = capacity;
+}
+
+void Output_writeSlow(OutputBuffer* out, const char* bytes, size_t length) {
+    if (out->fixed) {
+        out->length += length;
+        out->failed = true;
+        return;
+    }
+
+    if (!out->file) {
+        _grow(out, length);
+        if (out->failed) return;
+
+        memcpy(out->data + out->length, bytes, length);
+        out->length += length;
+        return;
+    }
+
+    Output_flush(out);
+
+    // payloads bigger than the whole buffer go straight to the file
+    if (length > out->capacity) {
+        if (out->file && fwrite(bytes, 1, length, out->file) != length)
+            out->failed = true;
+        return;
+    }
+
+    memcpy(out->data, bytes, length);
+    out->length = length;
+}
@@ -0,0 +1,89 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../Stats/Stats.h"
+
+#define OUTPUT_BUFFER_CAPACITY (64 * 1024)
+
+// Buffered byte sink used by the renderers.
+// Bytes are appended into `data` and handed to `file` in large chunks, so the
+// per-cell hot path is a bounds check plus a memcpy instead of a stdio call.
+// Without a file the buffer grows instead and keeps the whole output in `data`.
+typedef struct OutputBuffer {
+    FILE* file;
+    char* data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+    bool fixed;      // `data` is caller memory that is never grown nor freed
+} OutputBuffer;
+
+bool Output_initFile(OutputBuffer* out, FILE* file);
+bool Output_initMemory(OutputBuffer* out);
+
+// Writes into `capacity` bytes of caller memory. Bytes that do not fit are
+// dropped and mark the buffer as failed, but still count towards `length`.
+void Output_initFixed(OutputBuffer* out, char* data, size_t capacity);
+
+// Rebinds an initialized buffer to `file` (NULL for memory) and drops its contents
+void Output_reset(OutputBuffer* out, FILE* file);
+
+// Flushes pending bytes to the underlying file (no-op for memory buffers),
+// returns false if any write failed
+bool Output_flush(OutputBuffer* out);
+
+// Flushes and releases the buffer (does NOT close the file)
+bool Output_free(OutputBuffer* out);
+
+void Output_writeSlow(OutputBuffer* out, const char* bytes, size_t length);
+
+static inline void Output_write(OutputBuffer* out, const char* bytes, size_t length) {
+    if (out->length + length <= out->capacity) {
+        memcpy(out->data + out->length, bytes, length);
+        out->length += length;
+    } else {
+        Output_writeSlow(out, bytes, length);
+    }
+}
+
+static inline void Output_putc(OutputBuffer* out, char c) {
+    if (out->length < out->capacity)
+        out->data[out->length++] = c;
+    else
+        Output_writeSlow(out, &c, 1);
+}
+
+static inline void Output_puts(OutputBuffer* out, const char* str) {
+    Output_write(out, str, strlen(str));
+}
+
+// Writes a packed 0xRRGGBB color as #rrggbb
+static inline void Output_writeHexColor(OutputBuffer* out, uint32_t color) {
+    static const char HEX[] = "0123456789abcdef";
+
+    char hex[7] = { '#' };
+    for (int i = 0; i < 6; i++)
+        hex[1 + i] = HEX[(color >> (20 - 4 * i)) & 0xF];
+
+    Output_write(out, hex, sizeof(hex));
+}
+
+static inline void Output_writeUInt(OutputBuffer* out, unsigned long long value) {
+    char digits[20];
+    int len = 0;
+    do {
+        digits[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (len > 0)
+        Output_putc(out, digits[--len]);
+}
+
+#endif // OUTPUT_H
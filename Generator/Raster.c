@@ -0,0 +1,358 @@
+#include "Raster.h"
+
+// Atlas layout: printable ASCII, then every braille mask, then every sextant mask
+#define ATLAS_ASCII       0
+#define ATLAS_BRAILLE     (ATLAS_ASCII + FONT_GLYPH_COUNT)
+#define ATLAS_SEXTANT     (ATLAS_BRAILLE + 256)
+#define ATLAS_GLYPHS      (ATLAS_SEXTANT + 64)
+
+#define ATLAS_SPACE       (ATLAS_ASCII + (' ' - FONT_FIRST_CHAR))
+#define ATLAS_UNKNOWN     (ATLAS_ASCII + ('?' - FONT_FIRST_CHAR))
+
+// Every glyph expanded to one byte per pixel (0 or 1), so blitting is a
+// table lookup per pixel instead of bit twiddling
+typedef struct GlyphAtlas {
+    uint8_t pixels[ATLAS_GLYPHS][FONT_GLYPH_HEIGHT][FONT_GLYPH_WIDTH];
+} GlyphAtlas;
+
+typedef struct RasterCell {
+    uint16_t glyph;
+    uint32_t color;
+} RasterCell;
+
+typedef struct RasterJob {
+    const GlyphAtlas* atlas;
+    const RasterCell* cells;
+    const RasterOptions* options;
+    Image* image;
+    int columns;
+    int row_begin;
+    int row_end;
+} RasterJob;
+
+const RasterOptions DEFAULT_RASTER_OPTIONS = {
+    .scale_x = 1,
+    .scale_y = 2,
+    .foreground = 0xFFFFFF,
+    .background = 0x000000,
+};
+
+static void _buildAtlas(GlyphAtlas* atlas) {
+    memset(atlas, 0, sizeof(GlyphAtlas));
+
+    for (int c = FONT_FIRST_CHAR; c <= FONT_LAST_CHAR; c++) {
+        const uint8_t* glyph = Font_getGlyph((unsigned char)c);
+        for (int y = 0; y < FONT_GLYPH_HEIGHT; y++)
+            for (int x = 0; x < FONT_GLYPH_WIDTH; x++)
+                atlas->pixels[ATLAS_ASCII + c - FONT_FIRST_CHAR][y][x] = (glyph[y] >> x) & 1;
+    }
+
+    // braille dots: 2x1 pixels on the odd rows of each half of the cell
+    for (int mask = 0; mask < 256; mask++) {
+        for (int sy = 0; sy < SUBPIXEL_BRAILLE_ROWS; sy++) {
+            for (int sx = 0; sx < SUBPIXEL_BRAILLE_COLS; sx++) {
+                if (!(mask & Subpixel_brailleBit(sx, sy))) continue;
+
+                int py = sy * (FONT_GLYPH_HEIGHT / SUBPIXEL_BRAILLE_ROWS) + 1;
+                int px = sx * (FONT_GLYPH_WIDTH / SUBPIXEL_BRAILLE_COLS) + 1;
+                atlas->pixels[ATLAS_BRAILLE + mask][py][px] = 1;
+                atlas->pixels[ATLAS_BRAILLE + mask][py][px + 1] = 1;
+            }
+        }
+    }
+
+    // sextants: solid blocks on a 2x3 grid
+    for (int mask = 0; mask < 64; mask++) {
+        for (int y = 0; y < FONT_GLYPH_HEIGHT; y++) {
+            int sy = y * SUBPIXEL_SEXTANT_ROWS / FONT_GLYPH_HEIGHT;
+            for (int x = 0; x < FONT_GLYPH_WIDTH; x++) {
+                int sx = x * SUBPIXEL_SEXTANT_COLS / FONT_GLYPH_WIDTH;
+                atlas->pixels[ATLAS_SEXTANT + mask][y][x] = (mask & Subpixel_sextantBit(sx, sy)) ? 1 : 0;
+            }
+        }
+    }
+}
+
+static inline uint16_t _atlasIndex(uint32_t codepoint) {
+    if (codepoint >= FONT_FIRST_CHAR && codepoint <= FONT_LAST_CHAR)
+        return (uint16_t)(ATLAS_ASCII + codepoint - FONT_FIRST_CHAR);
+
+    if (codepoint >= 0x2800 && codepoint <= 0x28FF)
+        return (uint16_t)(ATLAS_BRAILLE + codepoint - 0x2800);
+
+    // sextants skip the masks that already exist as block elements
+    if (codepoint >= 0x1FB00 && codepoint <= 0x1FB3B) {
+        int mask = (int)(codepoint - 0x1FB00) + 1;
+        if (mask >= 21) mask++;
+        if (mask >= 42) mask++;
+        return (uint16_t)(ATLAS_SEXTANT + mask);
+    }
+
+    switch (codepoint) {
+        case 0x258C: return ATLAS_SEXTANT + 21;   // left half block
+        case 0x2590: return ATLAS_SEXTANT + 42;   // right half block
+        case 0x2588: return ATLAS_SEXTANT + 63;   // full block
+    }
+
+    return ATLAS_UNKNOWN;
+}
+
+// Decodes one UTF-8 sequence, invalid bytes decode as U+FFFD one at a time
+static inline size_t _decodeUTF8(const unsigned char* s, size_t length, uint32_t* codepoint) {
+    unsigned char lead = s[0];
+    size_t n;
+
+    if (lead < 0x80)                { *codepoint = lead;        return 1; }
+    else if ((lead & 0xE0) == 0xC0) { *codepoint = lead & 0x1F; n = 2; }
+    else if ((lead & 0xF0) == 0xE0) { *codepoint = lead & 0x0F; n = 3; }
+    else if ((lead & 0xF8) == 0xF0) { *codepoint = lead & 0x07; n = 4; }
+    else                            { *codepoint = 0xFFFD;      return 1; }
+
+    if (n > length) { *codepoint = 0xFFFD; return 1; }
+
+    for (size_t i = 1; i < n; i++) {
+        if ((s[i] & 0xC0) != 0x80) { *codepoint = 0xFFFD; return 1; }
+        *codepoint = (*codepoint << 6) | (s[i] & 0x3F);
+    }
+
+    return n;
+}
+
+// Parses the parameters of an SGR sequence (ESC [ ... m) and updates `color`
+static inline void _applySGR(const char* params, size_t length, uint32_t default_color, uint32_t* color) {
+    int values[16];
+    int count = 0;
+    int current = 0;
+    bool has_digits = false;
+
+    for (size_t i = 0; i <= length && count < 16; i++) {
+        if (i == length || params[i] == ';') {
+            values[count++] = has_digits ? current : 0;
+            current = 0;
+            has_digits = false;
+        } else if (params[i] >= '0' && params[i] <= '9') {
+            current = current * 10 + (params[i] - '0');
+            has_digits = true;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (values[i] == 0 || values[i] == 39) {
+            *color = default_color;
+        } else if (values[i] == 38 && i + 2 < count && values[i + 1] == 5) {
+            *color = Encoder_ansiPaletteColor(values[i + 2]);
+            i += 2;
+        } else if (values[i] == 38 && i + 4 < count && values[i + 1] == 2) {
+            *color = ((uint32_t)(values[i + 2] & 0xFF) << 16)
+                   | ((uint32_t)(values[i + 3] & 0xFF) << 8)
+                   |  (uint32_t)(values[i + 4] & 0xFF);
+            i += 4;
+        } else if (values[i] >= 30 && values[i] <= 37) {
+            *color = Encoder_ansiPaletteColor(values[i] - 30);
+        } else if (values[i] >= 90 && values[i] <= 97) {
+            *color = Encoder_ansiPaletteColor(values[i] - 90 + 8);
+        }
+    }
+}
+
+// Walks the text once; with `cells` == NULL only measures the grid
+static void _parseText(const char* text, size_t length, uint32_t default_color,
+                       RasterCell* cells, int columns,
+                       int* out_columns, int* out_rows) {
+    const unsigned char* s = (const unsigned char*)text;
+    uint32_t color = default_color;
+    int x = 0, y = 0, max_x = 0;
+    bool row_has_content = false;
+
+    size_t i = 0;
+    while (i < length) {
+        if (s[i] == '\n') {
+            if (x > max_x) max_x = x;
+            x = 0;
+            y++;
+            row_has_content = false;
+            i++;
+            continue;
+        }
+
+        if (s[i] == '\r') {
+            i++;
+            continue;
+        }
+
+        // CSI sequence: ESC [ params final-byte
+        if (s[i] == 0x1B && i + 1 < length && s[i + 1] == '[') {
+            size_t start = i + 2;
+            size_t end = start;
+            while (end < length && (s[end] < 0x40 || s[end] > 0x7E))
+                end++;
+
+            if (end < length && s[end] == 'm')
+                _applySGR(text + start, end - start, default_color, &color);
+
+            i = (end < length) ? end + 1 : length;
+            continue;
+        }
+
+        uint32_t codepoint;
+        i += _decodeUTF8(s + i, length - i, &codepoint);
+
+        if (cells) {
+            cells[(size_t)y * columns + x].glyph = _atlasIndex(codepoint);
+            cells[(size_t)y * columns + x].color = color;
+        }
+        x++;
+        row_has_content = true;
+    }
+
+    if (x > max_x) max_x = x;
+
+    *out_columns = max_x;
+    *out_rows = y + (row_has_content ? 1 : 0);
+}
+
+static void* _blitRows(void* arg) {
+    const RasterJob* job = arg;
+    const RasterOptions* options = job->options;
+    Image* image = job->image;
+
+    int cell_h = FONT_GLYPH_HEIGHT * options->scale_y;
+
+    uint8_t bg[3] = {
+        (uint8_t)(options->background >> 16),
+        (uint8_t)(options->background >> 8),
+        (uint8_t)(options->background)
+    };
+
+    // output is written strictly top to bottom, one scanline at a time
+    for (int row = job->row_begin; row < job->row_end; row++) {
+        const RasterCell* line = job->cells + (size_t)row * job->columns;
+
+        for (int py = 0; py < cell_h; py++) {
+            uint8_t* dst = Image_row(image, row * cell_h + py);
+            int gy = py / options->scale_y;
+
+            for (int col = 0; col < job->columns; col++) {
+                const uint8_t* pixels = job->atlas->pixels[line[col].glyph][gy];
+                uint8_t fg[3] = {
+                    (uint8_t)(line[col].color >> 16),
+                    (uint8_t)(line[col].color >> 8),
+                    (uint8_t)(line[col].color)
+                };
+
+                for (int gx = 0; gx < FONT_GLYPH_WIDTH; gx++) {
+                    const uint8_t* rgb = pixels[gx] ? fg : bg;
+                    for (int s = 0; s < options->scale_x; s++) {
+                        dst[0] = rgb[0];
+                        dst[1] = rgb[1];
+                        dst[2] = rgb[2];
+                        dst += 3;
+                    }
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+Image* Raster_renderText(const char* text, size_t length, const RasterOptions* options, Arena* scratch) {
+    if (!text) return NULL;
+    const RasterOptions* opts = options ? options : &DEFAULT_RASTER_OPTIONS;
+
+    if (opts->scale_x <= 0 || opts->scale_y <= 0) {
+        fprintf(stderr, "Raster: glyph scale must be positive.\n");
+        return NULL;
+    }
+
+    int columns, rows;
+    _parseText(text, length, opts->foreground, NULL, 0, &columns, &rows);
+    if (columns == 0 || rows == 0) {
+        fprintf(stderr, "Raster: nothing to render.\n");
+        return NULL;
+    }
+
+    // checked before anything is allocated: rows are padded by up to two
+    // alignments, and the PNG encoder adds a filter byte to each
+    int64_t width = (int64_t)columns * FONT_GLYPH_WIDTH * opts->scale_x;
+    int64_t height = (int64_t)rows * FONT_GLYPH_HEIGHT * opts->scale_y;
+    if (width > INT_MAX / 3 || height > INT_MAX || (width * 3 + 2 * IMAGE_ALIGNMENT) * height > INT_MAX) {
+        fprintf(stderr, "Raster: %dx%d cells at scale %dx%d are too large for one image.\n",
+                columns, rows, opts->scale_x, opts->scale_y);
+        return NULL;
+    }
+
+    size_t cells_size = (size_t)columns * rows * sizeof(RasterCell);
+    if (!scratch) Stats_countAllocations(2);
+    RasterCell* cells = scratch ? Arena_alloc(scratch, cells_size, ARENA_DEFAULT_ALIGNMENT) : malloc(cells_size);
+    GlyphAtlas* atlas = scratch ? Arena_alloc(scratch, sizeof(GlyphAtlas), ARENA_DEFAULT_ALIGNMENT) : malloc(sizeof(GlyphAtlas));
+    if (!cells || !atlas) {
+        fprintf(stderr, "Raster: failed to allocate cell grid.\n");
+        if (!scratch) {
+            free(cells);
+            free(atlas);
+        }
+        return NULL;
+    }
+
+    for (size_t i = 0; i < (size_t)columns * rows; i++) {
+        cells[i].glyph = ATLAS_SPACE;
+        cells[i].color = opts->foreground;
+    }
+
+    _parseText(text, length, opts->foreground, cells, columns, &columns, &rows);
+    _buildAtlas(atlas);
+
+    Image* image = Image_create((int)width, (int)height, 3, false);
+    if (!image) {
+        if (!scratch) {
+            free(cells);
+            free(atlas);
+        }
+        return NULL;
+    }
+
+    // text rows map to disjoint bands of the image, so they blit in parallel
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = rows / RASTER_MIN_ROWS_PER_THREAD;
+    if (threads > cpus) threads = (int)cpus;
+    if (threads > RASTER_MAX_THREADS) threads = RASTER_MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    RasterJob jobs[RASTER_MAX_THREADS];
+    pthread_t workers[RASTER_MAX_THREADS];
+    int started = 0;
+
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (RasterJob){
+            .atlas = atlas,
+            .cells = cells,
+            .options = opts,
+            .image = image,
+            .columns = columns,
+            .row_begin = rows * t / threads,
+            .row_end = rows * (t + 1) / threads,
+        };
+    }
+
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&workers[t], NULL, _blitRows, &jobs[t]) != 0)
+            break;
+        started = t;
+    }
+
+    // the calling thread takes the first band plus any band a thread failed to start for
+    _blitRows(&jobs[0]);
+    for (int t = started + 1; t < threads; t++)
+        _blitRows(&jobs[t]);
+
+    for (int t = 1; t <= started; t++)
+        pthread_join(workers[t], NULL);
+
+    if (!scratch) {
+        free(cells);
+        free(atlas);
+    }
+
+    return image;
+}
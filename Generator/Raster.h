@@ -0,0 +1,39 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "Encoder.h"
+#include "Subpixel.h"
+#include "../Arena/Arena.h"
+#include "../Font/Font.h"
+#include "../Image/Image.h"
+
+// Text rows handed to each blitting thread at minimum
+#define RASTER_MIN_ROWS_PER_THREAD 16
+#define RASTER_MAX_THREADS         16
+
+typedef struct RasterOptions {
+    int scale_x;            // output pixels per font pixel, horizontally
+    int scale_y;            // output pixels per font pixel, vertically
+    uint32_t foreground;    // 0xRRGGBB used until an ANSI color is set
+    uint32_t background;    // 0xRRGGBB
+} RasterOptions;
+
+extern const RasterOptions DEFAULT_RASTER_OPTIONS;
+
+// Rasterizes ASCII art (plain, ANSI-colored, braille or sextant text) into an
+// RGB image, one FONT_GLYPH_WIDTH x FONT_GLYPH_HEIGHT glyph per cell.
+// - The caller owns the returned image.
+// - The cell grid and glyph atlas come from `scratch` when given, else from the heap.
+// - NULL (with an error) when the image would be too large for the PNG encoder,
+//   which sizes its buffers in int.
+Image* Raster_renderText(const char* text, size_t length, const RasterOptions* options, Arena* scratch);
+
+#endif // RASTER_H
@@ -0,0 +1,295 @@
+#include "Resample.h"
+
+static inline uint32_t _gcd(uint32_t a, uint32_t b) {
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static bool _allocAxis(ResampleAxis* axis, Arena* arena, int cells, size_t weights) {
+    axis->start = Arena_alloc(arena, (size_t)cells * sizeof(int), ARENA_DEFAULT_ALIGNMENT);
+    axis->length = Arena_alloc(arena, (size_t)cells * sizeof(int), ARENA_DEFAULT_ALIGNMENT);
+    axis->offset = Arena_alloc(arena, (size_t)cells * sizeof(int), ARENA_DEFAULT_ALIGNMENT);
+    axis->weights = Arena_alloc(arena, weights * sizeof(int32_t), ARENA_DEFAULT_ALIGNMENT);
+    axis->narrow = NULL;
+    return axis->start && axis->length && axis->offset && axis->weights;
+}
+
+static bool _initBoxAxis(ResampleAxis* axis, Arena* arena, int pixels, int cells) {
+    // a span reaches at most one pixel past its share of the axis
+    if (!_allocAxis(axis, arena, cells, (size_t)pixels + cells))
+        return false;
+
+    // every edge is a multiple of both counts, so their gcd divides all weights
+    uint32_t unit = _gcd((uint32_t)pixels, (uint32_t)cells);
+    int32_t inner = (int32_t)((uint32_t)cells / unit);
+    axis->total = (uint32_t)pixels / unit;
+
+    int offset = 0;
+    for (int c = 0; c < cells; c++) {
+        uint64_t from = (uint64_t)c * pixels;           // in 1 / cells pixel
+        uint64_t to = (uint64_t)(c + 1) * pixels;
+        int start = (int)(from / cells);
+        int end = (int)((to + cells - 1) / cells);
+
+        int32_t* w = axis->weights + offset;
+        for (int k = 0; k < end - start; k++)
+            w[k] = inner;
+
+        uint64_t first_end = (uint64_t)(start + 1) * cells;
+        w[0] = (int32_t)((((first_end < to) ? first_end : to) - from) / unit);
+        if (end - start > 1)
+            w[end - start - 1] = (int32_t)((to - (uint64_t)(end - 1) * cells) / unit);
+
+        axis->start[c] = start;
+        axis->length[c] = end - start;
+        axis->offset[c] = offset;
+        offset += end - start;
+    }
+
+    return true;
+}
+
+static inline double _sinc(double t) {
+    if (t == 0.0) return 1.0;
+    t *= M_PI;
+    return sin(t) / t;
+}
+
+static inline double _kernel(ResampleFilter filter, double t) {
+    t = fabs(t);
+    if (filter == RESAMPLE_TRIANGLE)
+        return t < 1.0 ? 1.0 - t : 0.0;
+    return t < 3.0 ? _sinc(t) * _sinc(t / 3.0) : 0.0;
+}
+
+// Continuous filters are centered on each cell and widened by the cell size
+// when downsampling, so every pixel under the support counts. Weights are
+// computed once per axis in doubles and rounded, the rounding error going to
+// the largest weight so each cell adds up to exactly RESAMPLE_FILTER_ONE.
+static bool _initFilterAxis(ResampleAxis* axis, Arena* arena, int pixels, int cells, ResampleFilter filter) {
+    double scale = (double)pixels / cells;
+    double width = scale > 1.0 ? scale : 1.0;
+    double support = (filter == RESAMPLE_TRIANGLE ? 1.0 : 3.0) * width;
+    int max_length = (int)ceil(2.0 * support) + 2;
+
+    double* kernel = Arena_alloc(arena, (size_t)max_length * sizeof(double), ARENA_DEFAULT_ALIGNMENT);
+    if (!kernel || !_allocAxis(axis, arena, cells, (size_t)cells * max_length))
+        return false;
+    axis->total = RESAMPLE_FILTER_ONE;
+
+    int offset = 0;
+    for (int c = 0; c < cells; c++) {
+        double center = (c + 0.5) * scale;
+        int start = (int)floor(center - support);
+        int end = (int)ceil(center + support);
+        if (start < 0) start = 0;
+        if (end > pixels) end = pixels;
+
+        double sum = 0.0;
+        for (int x = start; x < end; x++) {
+            kernel[x - start] = _kernel(filter, (x + 0.5 - center) / width);
+            sum += kernel[x - start];
+        }
+
+        int32_t* w = axis->weights + offset;
+        int32_t total = 0;
+        int largest = 0;
+        for (int k = 0; k < end - start; k++) {
+            w[k] = (int32_t)lround(kernel[k] / sum * RESAMPLE_FILTER_ONE);
+            total += w[k];
+            if (w[k] > w[largest]) largest = k;
+        }
+        w[largest] += RESAMPLE_FILTER_ONE - total;
+
+        axis->start[c] = start;
+        axis->length[c] = end - start;
+        axis->offset[c] = offset;
+        offset += end - start;
+    }
+
+    return true;
+}
+
+// Copies the weights to 16 bits when every cell's byte sum also fits in 32
+static bool _narrowAxis(ResampleAxis* axis, Arena* arena, int cells) {
+    int count = axis->offset[cells - 1] + axis->length[cells - 1];
+    for (int c = 0; c < cells; c++) {
+        const int32_t* w = axis->weights + axis->offset[c];
+        int64_t magnitude = 0;
+        for (int k = 0; k < axis->length[c]; k++) {
+            if (w[k] > INT16_MAX || w[k] < -INT16_MAX) return true;
+            magnitude += w[k] < 0 ? -w[k] : w[k];
+        }
+        if (magnitude * 255 > INT32_MAX) return true;
+    }
+
+    int16_t* narrow = Arena_alloc(arena, (size_t)count * sizeof(int16_t), ARENA_DEFAULT_ALIGNMENT);
+    if (!narrow) return false;
+
+    for (int k = 0; k < count; k++)
+        narrow[k] = (int16_t)axis->weights[k];
+    axis->narrow = narrow;
+    return true;
+}
+
+static inline bool _initAxis(ResampleAxis* axis, Arena* arena, int pixels, int cells, ResampleFilter filter) {
+    return filter == RESAMPLE_BOX ? _initBoxAxis(axis, arena, pixels, cells)
+                                  : _initFilterAxis(axis, arena, pixels, cells, filter);
+}
+
+// Horizontal pass: the weighted sum of every column of cells over one row
+static void _reduceRow(const ResampleAxis* axis, const uint8_t* row, const GammaTables* gamma,
+                       int columns, int64_t* out) {
+    if (!gamma && axis->narrow) {
+        const Kernels* kernels = Kernels_get();
+        for (int c = 0; c < columns; c++)
+            out[c] = kernels->dotRow(row + axis->start[c], axis->narrow + axis->offset[c], axis->length[c]);
+        return;
+    }
+
+    for (int c = 0; c < columns; c++) {
+        const int32_t* w = axis->weights + axis->offset[c];
+        const uint8_t* p = row + axis->start[c];
+        int length = axis->length[c];
+        int64_t sum = 0;
+
+        if (gamma) {
+            const uint16_t* lut = gamma->to_linear;
+            for (int k = 0; k < length; k++)
+                sum += (int64_t)w[k] * lut[p[k]];
+        } else {
+            for (int k = 0; k < length; k++)
+                sum += (int64_t)w[k] * p[k];
+        }
+
+        out[c] = sum;
+    }
+}
+
+// _reduceRow for the first three channels of interleaved pixels, one output
+// plane per channel. With `planes` the row is split into them first, so each
+// channel goes through the same vector dot product as gray rows.
+static void _reduceRowRGB(const ResampleAxis* axis, const uint8_t* row, int channels, const GammaTables* gamma,
+                          int width, int columns, uint8_t* planes[3], int64_t* out[3]) {
+    if (planes[0]) {
+        for (int x = 0; x < width; x++, row += channels) {
+            planes[0][x] = row[0];
+            planes[1][x] = row[1];
+            planes[2][x] = row[2];
+        }
+        for (int p = 0; p < 3; p++)
+            _reduceRow(axis, planes[p], NULL, columns, out[p]);
+        return;
+    }
+
+    for (int c = 0; c < columns; c++) {
+        const int32_t* w = axis->weights + axis->offset[c];
+        const uint8_t* p = row + (size_t)axis->start[c] * channels;
+        int length = axis->length[c];
+        int64_t r = 0, g = 0, b = 0;
+
+        if (gamma) {
+            const uint16_t* lut = gamma->to_linear;
+            for (int k = 0; k < length; k++, p += channels) {
+                r += (int64_t)w[k] * lut[p[0]];
+                g += (int64_t)w[k] * lut[p[1]];
+                b += (int64_t)w[k] * lut[p[2]];
+            }
+        } else {
+            for (int k = 0; k < length; k++, p += channels) {
+                r += (int64_t)w[k] * p[0];
+                g += (int64_t)w[k] * p[1];
+                b += (int64_t)w[k] * p[2];
+            }
+        }
+
+        out[0][c] = r;
+        out[1][c] = g;
+        out[2][c] = b;
+    }
+}
+
+// Vertical pass: adds `weight` times a reduced row into a row of cells
+static inline void _accumulate(int64_t* restrict cells, const int64_t* restrict row, int64_t weight, int columns) {
+    for (int c = 0; c < columns; c++)
+        cells[c] += weight * row[c];
+}
+
+bool ResampleGrid_build(ResampleGrid* grid, Arena* arena, const Image* img, const GammaTables* gamma,
+                        int columns, int rows, ResampleFilter filter) {
+    if (!_initAxis(&grid->x, arena, img->width, columns, filter) ||
+        !_initAxis(&grid->y, arena, img->height, rows, filter) ||
+        !_narrowAxis(&grid->x, arena, columns))
+        return false;
+
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->channels = img->channels >= 3 ? 3 : 1;
+    grid->weight = grid->x.total * grid->y.total;
+    grid->reciprocal = Fixed_reciprocal((uint64_t)grid->weight);
+
+    // splitting color rows into planes only pays off when the filters overlap
+    // and read every pixel several times
+    const ResampleAxis* ax = &grid->x;
+    bool split = grid->channels == 3 && !gamma && ax->narrow && img->layout == IMAGE_INTERLEAVED &&
+                 ax->offset[columns - 1] + ax->length[columns - 1] >= 2 * img->width;
+    // gray + alpha rows are packed down to their gray bytes
+    bool pack = img->layout == IMAGE_INTERLEAVED && img->channels == 2;
+
+    size_t cells = (size_t)columns * rows;
+    int64_t* reduced[3];
+    uint8_t* planes[3] = { NULL, NULL, NULL };
+    for (int c = 0; c < grid->channels; c++) {
+        grid->sums[c] = Arena_alloc(arena, cells * sizeof(int64_t), ARENA_DEFAULT_ALIGNMENT);
+        reduced[c] = Arena_alloc(arena, (size_t)columns * sizeof(int64_t), ARENA_DEFAULT_ALIGNMENT);
+        if (!grid->sums[c] || !reduced[c]) return false;
+
+        if (split || pack) {
+            planes[c] = Arena_alloc(arena, (size_t)img->width, ARENA_DEFAULT_ALIGNMENT);
+            if (!planes[c]) return false;
+        }
+        memset(grid->sums[c], 0, cells * sizeof(int64_t));
+    }
+    for (int c = grid->channels; c < 3; c++)
+        grid->sums[c] = grid->sums[0];
+
+    const ResampleAxis* ay = &grid->y;
+    int first = 0;  // first row of cells still reading source rows
+
+    // rows of cells read a window of source rows that only moves forward, so
+    // each source row is reduced once and added into the few cell rows over it
+    for (int y = 0; y < img->height; y++) {
+        while (first < rows && ay->start[first] + ay->length[first] <= y)
+            first++;
+        if (first == rows) break;
+        if (ay->start[first] > y) continue;
+
+        // planar images already hold each channel's row on its own
+        if (img->layout == IMAGE_PLANAR) {
+            for (int c = 0; c < grid->channels; c++)
+                _reduceRow(&grid->x, img->planes[c] + (size_t)y * img->stride, gamma, columns, reduced[c]);
+        } else if (grid->channels == 1) {
+            const uint8_t* row = Image_row(img, y);
+            if (pack) {
+                for (int x = 0; x < img->width; x++)
+                    planes[0][x] = row[2 * x];
+                row = planes[0];
+            }
+            _reduceRow(&grid->x, row, gamma, columns, reduced[0]);
+        } else {
+            _reduceRowRGB(&grid->x, Image_row(img, y), img->channels, gamma, img->width, columns, planes, reduced);
+        }
+
+        for (int r = first; r < rows && ay->start[r] <= y; r++) {
+            int64_t weight = ay->weights[ay->offset[r] + (y - ay->start[r])];
+            for (int c = 0; c < grid->channels; c++)
+                _accumulate(grid->sums[c] + (size_t)r * columns, reduced[c], weight, columns);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FixedPoint.h"
+#include "Gamma.h"
+#include "../Kernels/Kernels.h"
+#include "../Arena/Arena.h"
+#include "../Image/Image.h"
+
+typedef enum ResampleFilter {
+    RESAMPLE_BOX,       // the pixels a cell covers, by the exact part it covers
+    RESAMPLE_TRIANGLE,  // tent over twice the cell size, centered on the cell
+    RESAMPLE_LANCZOS    // 3-lobe Lanczos windowed sinc over six cell sizes
+} ResampleFilter;
+
+// Integer weights of the pixels each cell of one axis reads. Box weights are
+// exact: cell c covers [c * pixels / cells, (c + 1) * pixels / cells), and in
+// units of 1 / cells pixel (reduced by the gcd) every overlap is an integer.
+// Triangle and Lanczos weights are rounded to add up to RESAMPLE_FILTER_ONE.
+// Spans only ever move forward from one cell to the next.
+typedef struct ResampleAxis {
+    int* start;         // first pixel read by each cell
+    int* length;        // pixels read by each cell
+    int* offset;        // of each cell's weights in `weights`
+    int32_t* weights;
+    int16_t* narrow;    // the same weights for Kernels.dotRow, NULL when they do not fit
+    int64_t total;      // the weights of every cell add up to this
+} ResampleAxis;
+
+#define RESAMPLE_FILTER_BITS 14
+#define RESAMPLE_FILTER_ONE  (1 << RESAMPLE_FILTER_BITS)
+
+// Filtered sums of every cell of a columns x rows grid over an image, one
+// row-major plane per channel. Lanczos lobes can take a sum below zero or
+// above white, so means must be clamped.
+typedef struct ResampleGrid {
+    ResampleAxis x;
+    ResampleAxis y;
+    int columns;
+    int rows;
+    int channels;           // 1 for single-channel images, else 3 (R, G, B)
+    int64_t* sums[3];
+    int64_t weight;         // of a whole cell, x.total * y.total
+    uint64_t reciprocal;    // Fixed_reciprocal of weight
+} ResampleGrid;
+
+// Filters `img` down (or up) to a columns x rows grid in one sweep over its
+// rows: each row is reduced to per-column sums, which are added into the rows
+// of cells that read it. Sums are in linear light with `gamma`. Everything
+// comes from `arena`; false when out of memory.
+bool ResampleGrid_build(ResampleGrid* grid, Arena* arena, const Image* img, const GammaTables* gamma,
+                        int columns, int rows, ResampleFilter filter);
+
+// Sum of channel `c` of cell (cx, cy), clamped to [0, weight * white] where
+// white is 65535 with gamma tables and 255 without
+static inline uint64_t ResampleGrid_sum(const ResampleGrid* grid, int c, int cx, int cy, int64_t white) {
+    int64_t sum = grid->sums[c][(size_t)cy * grid->columns + cx];
+    int64_t max = grid->weight * white;
+    return (uint64_t)(sum < 0 ? 0 : (sum > max ? max : sum));
+}
+
+#endif // RESAMPLE_H
@@ -0,0 +1,153 @@
+#include "SVG.h"
+
+#define LITERAL(out, str)       Output_write((out), (str), sizeof(str) - 1)
+
+static const char SVG_OPEN[]        = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"";
+static const char SVG_HEIGHT[]      = "\" height=\"";
+static const char SVG_VIEWBOX[]     = "\" viewBox=\"0 0 ";
+static const char SVG_FONT[]        = "\" font-family=\"monospace\" font-size=\"";
+static const char SVG_OPEN_END[]    = "\" xml:space=\"preserve\">\n";
+static const char SVG_BACKGROUND_COLORED[] = "<rect width=\"100%\" height=\"100%\" fill=\"#000\"/>\n<g fill=\"#fff\">\n";
+static const char SVG_BACKGROUND_PLAIN[]   = "<rect width=\"100%\" height=\"100%\" fill=\"#fff\"/>\n<g fill=\"#000\">\n";
+static const char SVG_TAIL[]        = "</g>\n</svg>\n";
+static const char SVG_ROW_OPEN[]    = "<text y=\"";
+static const char SVG_ROW_CLOSE[]   = "</text>\n";
+static const char SVG_SPAN_OPEN[]   = "<tspan fill=\"";
+static const char SVG_SPAN_CLOSE[]  = "</tspan>";
+static const char SVG_ATTR_END[]    = "\">";
+
+// longest escaped single-byte glyph (&amp;)
+#define SVG_MAX_ESCAPE 5
+
+static inline void _openRow(SVGWriter* writer) {
+    OutputBuffer* out = writer->out;
+
+    // baseline sits a quarter cell above the bottom edge
+    LITERAL(out, SVG_ROW_OPEN);
+    Output_writeUInt(out, (unsigned long long)writer->row * SVG_CELL_HEIGHT + SVG_CELL_HEIGHT - SVG_CELL_HEIGHT / 4);
+    LITERAL(out, SVG_ATTR_END);
+
+    writer->row_open = true;
+}
+
+static inline void _closeSpan(SVGWriter* writer) {
+    if (writer->span_open) {
+        LITERAL(writer->out, SVG_SPAN_CLOSE);
+        writer->span_open = false;
+    }
+}
+
+bool SVG_begin(SVGWriter* writer, OutputBuffer* out, bool colored, int columns, int rows) {
+    writer->out = out;
+    writer->colored = colored;
+    writer->row = 0;
+    writer->row_open = false;
+    writer->span_open = false;
+    writer->span_color = 0;
+
+    unsigned long long width = (unsigned long long)columns * SVG_CELL_WIDTH;
+    unsigned long long height = (unsigned long long)rows * SVG_CELL_HEIGHT;
+
+    LITERAL(out, SVG_OPEN);
+    Output_writeUInt(out, width);
+    LITERAL(out, SVG_HEIGHT);
+    Output_writeUInt(out, height);
+    LITERAL(out, SVG_VIEWBOX);
+    Output_writeUInt(out, width);
+    Output_putc(out, ' ');
+    Output_writeUInt(out, height);
+    LITERAL(out, SVG_FONT);
+    Output_writeUInt(out, SVG_FONT_SIZE);
+    LITERAL(out, SVG_OPEN_END);
+
+    if (colored)
+        LITERAL(out, SVG_BACKGROUND_COLORED);
+    else
+        LITERAL(out, SVG_BACKGROUND_PLAIN);
+
+    return true;
+}
+
+void SVG_putCell(SVGWriter* writer, const char* glyph, size_t glyph_length, uint32_t color) {
+    OutputBuffer* out = writer->out;
+
+    if (!writer->row_open)
+        _openRow(writer);
+
+    if (writer->colored && (!writer->span_open || writer->span_color != color)) {
+        _closeSpan(writer);
+
+        LITERAL(out, SVG_SPAN_OPEN);
+        Output_writeHexColor(out, color);
+        LITERAL(out, SVG_ATTR_END);
+
+        writer->span_open = true;
+        writer->span_color = color;
+    }
+
+    if (glyph_length == 1) {
+        switch (glyph[0]) {
+            case '<': Output_write(out, "&lt;", 4);  return;
+            case '>': Output_write(out, "&gt;", 4);  return;
+            case '&': Output_write(out, "&amp;", 5); return;
+        }
+    }
+
+    Output_write(out, glyph, glyph_length);
+}
+
+void SVG_endRow(SVGWriter* writer) {
+    if (!writer->row_open)
+        _openRow(writer);
+
+    // a <tspan> cannot outlive its <text>, so runs restart on every row
+    _closeSpan(writer);
+    LITERAL(writer->out, SVG_ROW_CLOSE);
+
+    writer->row_open = false;
+    writer->row++;
+}
+
+bool SVG_end(SVGWriter* writer) {
+    if (writer->row_open)
+        SVG_endRow(writer);
+
+    LITERAL(writer->out, SVG_TAIL);
+
+    return !writer->out->failed;
+}
+
+static inline size_t _digitCount(unsigned long long value) {
+    size_t len = 1;
+    while (value >= 10) {
+        value /= 10;
+        len++;
+    }
+    return len;
+}
+
+size_t SVG_maxOutputSize(bool colored, size_t columns, size_t rows, size_t max_glyph_length) {
+    unsigned long long width = (unsigned long long)columns * SVG_CELL_WIDTH;
+    unsigned long long height = (unsigned long long)rows * SVG_CELL_HEIGHT;
+    size_t glyph = (max_glyph_length > SVG_MAX_ESCAPE) ? max_glyph_length : SVG_MAX_ESCAPE;
+
+    size_t size = sizeof(SVG_OPEN) - 1
+                + sizeof(SVG_HEIGHT) - 1
+                + sizeof(SVG_VIEWBOX) - 1
+                + sizeof(SVG_FONT) - 1
+                + sizeof(SVG_OPEN_END) - 1
+                + 2 * (_digitCount(width) + _digitCount(height)) + 1
+                + _digitCount(SVG_FONT_SIZE)
+                + (colored ? sizeof(SVG_BACKGROUND_COLORED) : sizeof(SVG_BACKGROUND_PLAIN)) - 1
+                + sizeof(SVG_TAIL) - 1;
+
+    // the last row has the largest baseline
+    size += rows * (sizeof(SVG_ROW_OPEN) - 1 + _digitCount(height) + sizeof(SVG_ATTR_END) - 1 + sizeof(SVG_ROW_CLOSE) - 1);
+    size += columns * rows * glyph;
+
+    // worst case: every cell opens its own run
+    if (colored)
+        size += columns * rows * (sizeof(SVG_SPAN_OPEN) - 1 + 7 + sizeof(SVG_ATTR_END) - 1 + sizeof(SVG_SPAN_CLOSE) - 1);
+
+    return size;
+}
@@ -0,0 +1,35 @@
+#ifndef SVG_H
+#define SVG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Output.h"
+
+// Cell size in SVG user units; the font size is chosen so that a
+// monospace glyph advance (0.6em) matches the cell width
+#define SVG_CELL_WIDTH  6
+#define SVG_CELL_HEIGHT 12
+#define SVG_FONT_SIZE   10
+
+// Streams one <text> element per row, with a <tspan> per run of same-colored
+// cells, so memory use does not depend on the grid size
+typedef struct SVGWriter {
+    OutputBuffer* out;
+    bool colored;
+    int row;
+    bool row_open;
+    bool span_open;
+    uint32_t span_color;
+} SVGWriter;
+
+bool SVG_begin(SVGWriter* writer, OutputBuffer* out, bool colored, int columns, int rows);
+void SVG_putCell(SVGWriter* writer, const char* glyph, size_t glyph_length, uint32_t color);
+void SVG_endRow(SVGWriter* writer);
+bool SVG_end(SVGWriter* writer);
+
+// Upper bound of the document size for a grid with `max_glyph_length` bytes per glyph
+size_t SVG_maxOutputSize(bool colored, size_t columns, size_t rows, size_t max_glyph_length);
+
+#endif // SVG_H
@@ -0,0 +1,98 @@
+#include "ShapeMatch.h"
+
+static inline void _rasterizeFeatures(unsigned char c, float* out) {
+    const uint8_t* glyph = Font_getGlyph(c);
+
+    const int cell_w = FONT_GLYPH_WIDTH / SHAPE_GRID_COLS;
+    const int cell_h = FONT_GLYPH_HEIGHT / SHAPE_GRID_ROWS;
+
+    for (int gy = 0; gy < SHAPE_GRID_ROWS; gy++) {
+        for (int gx = 0; gx < SHAPE_GRID_COLS; gx++) {
+            int count = 0;
+            for (int y = gy * cell_h; y < (gy + 1) * cell_h; y++)
+                for (int x = gx * cell_w; x < (gx + 1) * cell_w; x++)
+                    count += (glyph[y] >> x) & 1;
+
+            out[gy * SHAPE_GRID_COLS + gx] = (float)count / (cell_w * cell_h);
+        }
+    }
+}
+
+ShapeMatcher* ShapeMatch_create(const char* char_set) {
+    int len = (int)strlen(char_set);
+    if (len == 0) return NULL;
+
+    Stats_countAllocations(1);
+    ShapeMatcher* matcher = calloc(1, sizeof(ShapeMatcher));
+    if (!matcher) {
+        fprintf(stderr, "ShapeMatch: failed to allocate matcher.\n");
+        return NULL;
+    }
+
+    bool seen[256] = { false };
+    float max_mean = 0.0f;
+
+    for (int i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)char_set[i];
+        if (seen[c]) continue;
+        seen[c] = true;
+
+        float features[SHAPE_FEATURES];
+        _rasterizeFeatures(c, features);
+
+        int g = matcher->count++;
+        matcher->glyphs[g] = (char)c;
+
+        float mean = 0.0f;
+        for (int f = 0; f < SHAPE_FEATURES; f++) {
+            matcher->features[f * SHAPE_MAX_GLYPHS + g] = features[f];
+            mean += features[f];
+        }
+        mean /= SHAPE_FEATURES;
+        if (mean > max_mean) max_mean = mean;
+    }
+
+    for (int g = 0; g < matcher->count; g++) {
+        float norm = 0.0f;
+        for (int f = 0; f < SHAPE_FEATURES; f++) {
+            float v = matcher->features[f * SHAPE_MAX_GLYPHS + g];
+            norm += v * v;
+        }
+        matcher->bias[g] = -0.5f * norm;
+    }
+
+    // full ink maps onto the densest glyph, the same way the brightness
+    // mapping stretches the charset over the whole 0-255 range
+    matcher->ink_scale = (max_mean > 0.0f) ? max_mean / 255.0f : 1.0f / 255.0f;
+
+    matcher->dark_ink = Font_glyphCoverage((unsigned char)char_set[0]) >= Font_glyphCoverage((unsigned char)char_set[len - 1]);
+
+    return matcher;
+}
+
+void ShapeMatch_free(ShapeMatcher* matcher) {
+    free(matcher);
+}
+
+char ShapeMatch_findBest(const ShapeMatcher* matcher, const float* patch) {
+    // argmin |p - g|^2 == argmax (p . g - |g|^2 / 2)
+    float scores[SHAPE_MAX_GLYPHS];
+    memcpy(scores, matcher->bias, matcher->count * sizeof(float));
+
+    for (int f = 0; f < SHAPE_FEATURES; f++) {
+        float ink = matcher->dark_ink ? (255.0f - patch[f]) : patch[f];
+        ink *= matcher->ink_scale;
+
+        const float* row = &matcher->features[f * SHAPE_MAX_GLYPHS];
+        for (int g = 0; g < matcher->count; g++)
+            scores[g] += ink * row[g];
+    }
+
+    int best = 0;
+    for (int g = 1; g < matcher->count; g++) {
+        if (scores[g] > scores[best])
+            best = g;
+    }
+
+    return matcher->glyphs[best];
+}
@@ -0,0 +1,41 @@
+#ifndef SHAPEMATCH_H
+#define SHAPEMATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../Font/Font.h"
+#include "../Stats/Stats.h"
+
+// Every cell and every glyph is described by the ink coverage of a
+// SHAPE_GRID_COLS x SHAPE_GRID_ROWS grid of sub-regions
+#define SHAPE_GRID_COLS 4
+#define SHAPE_GRID_ROWS 4
+#define SHAPE_FEATURES  (SHAPE_GRID_COLS * SHAPE_GRID_ROWS)
+
+#define SHAPE_MAX_GLYPHS 256
+
+typedef struct ShapeMatcher {
+    int count;
+    char glyphs[SHAPE_MAX_GLYPHS];
+    // feature-major: features[f * SHAPE_MAX_GLYPHS + g], so one patch is
+    // scored against every glyph with contiguous multiply-adds
+    float features[SHAPE_FEATURES * SHAPE_MAX_GLYPHS];
+    // -|g|^2 / 2 of every glyph
+    float bias[SHAPE_MAX_GLYPHS];
+    // maps 0-255 ink onto the coverage range of the charset
+    float ink_scale;
+    // whether dark pixels count as ink, derived from the charset ordering
+    bool dark_ink;
+} ShapeMatcher;
+
+ShapeMatcher* ShapeMatch_create(const char* char_set);
+void ShapeMatch_free(ShapeMatcher* matcher);
+
+// Returns the glyph closest (least squares) to the given patch of
+// SHAPE_FEATURES luminance samples (0-255, row-major)
+char ShapeMatch_findBest(const ShapeMatcher* matcher, const float* patch);
+
+#endif // SHAPEMATCH_H
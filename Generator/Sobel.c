@@ -3,17 +3,9 @@
 #include <stdio.h>
 #include <string.h>
 
-static const int SOBEL_X[3][3] = {
-    { -1,   0,   1 },
-    { -2,   0,  -2 },
-    { -1,   0,   1 }
-};
-
-static const int SOBEL_Y[3][3] = {
-    { -1,  -2,  -1 },
-    {  0,   0,   0 },
-    {  1,   2,   1 }
-};
+// The 3x3 kernels live in Kernels_sobelAt and its vector versions:
+//   X = { -1, 0, 1 }, { -2, 0, -2 }, { -1, 0, 1 }
+//   Y = { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 }
 
 // static inline unsigned int _getPixelSafe(const Image* img, int x, int y) {
 //     if (x < 0) x = 0;
@@ -37,55 +29,42 @@ static const int SOBEL_Y[3][3] = {
 //     *out_value = sum;
 // }
 
-void Sobel_applySobelEdgeDetection(Image* img, bool normalize, float threshold) {
+float Sobel_edgeRows(const Image* img, int first, int count, uint8_t* out, size_t out_stride) {
+    const Kernels* kernels = Kernels_get();
+    float max_val = 0.0f;
+
+    // rows clamp at the top and bottom edges, columns inside the kernel
+    for (int y = first; y < first + count; y++, out += out_stride) {
+        const unsigned char* above = Image_row(img, y > 0 ? y - 1 : 0);
+        const unsigned char* row = Image_row(img, y);
+        const unsigned char* below = Image_row(img, y < img->height - 1 ? y + 1 : y);
+
+        float row_max = kernels->sobelRow(above, row, below, out, img->width);
+        if (row_max > max_val)
+            max_val = row_max;
+    }
+
+    return max_val;
+}
+
+void Sobel_applySobelEdgeDetection(Image* img, bool normalize, float threshold, unsigned char* scratch) {
     if (!img || img->channels != 1) {
         fprintf(stderr, "Sobel: Input image must be grayscale.\n");
         return;
     }
 
-    unsigned char* output = malloc(img->width * img->height);
+    if (!scratch) Stats_countAllocations(1);
+    unsigned char* output = scratch ? scratch : malloc((size_t)img->width * img->height);
     if (!output) {
         fprintf(stderr, "Sobel: Failed to allocate memory for result image.\n");
         return;
     }
 
-    float gx, gy;
-    float max_val = 0.0f;
-
-    for (int y = 0; y < img->height; y++) {
-        for (int x = 0; x < img->width; x++) {
-
-            gx = gy = 0.0f;
-
-            // 3×3 convolution with border clamping
-            for (int ky = -1; ky <= 1; ky++) {
-                for (int kx = -1; kx <= 1; kx++) {
-                    int xx = x + kx;
-                    int yy = y + ky;
-
-                    if (xx < 0) xx = 0;
-                    if (yy < 0) yy = 0;
-                    if (xx >= img->width)  xx = img->width - 1;
-                    if (yy >= img->height) yy = img->height - 1;
-
-                    unsigned char pixel = img->data[yy * img->width + xx];
-
-                    gx += SOBEL_X[ky + 1][kx + 1] * pixel;
-                    gy += SOBEL_Y[ky + 1][kx + 1] * pixel;
-                }
-            }
-
-            float magnitude = sqrtf(gx * gx + gy * gy);
-            if (magnitude > max_val)
-                max_val = magnitude;
-
-            output[y * img->width + x] = (unsigned char)fminf(magnitude, 255.0f);
-        }
-    }
+    float max_val = Sobel_edgeRows(img, 0, img->height, output, (size_t)img->width);
 
     // Optional normalization
     if (normalize && max_val > 0.0f) {
-        for (int i = 0; i < img->width * img->height; i++) {
+        for (size_t i = 0; i < (size_t)img->width * img->height; i++) {
             float val = ((float)output[i] / max_val) * 255.0f;
             output[i] = (unsigned char)fminf(val, 255.0f);
         }
@@ -93,13 +72,14 @@ void Sobel_applySobelEdgeDetection(Image* img, bool normalize, float threshold)
 
     // Optional threshold
     if (threshold > 0.0f) {
-        for (int i = 0; i < img->width * img->height; i++) {
+        for (size_t i = 0; i < (size_t)img->width * img->height; i++) {
             if (output[i] < threshold)
                 output[i] = 0;
         }
     }
 
-    memcpy(img->data, output, img->width * img->height);
-    free(output);
+    for (int y = 0; y < img->height; y++)
+        memcpy(Image_row(img, y), output + (size_t)y * img->width, (size_t)img->width);
+    if (output != scratch) free(output);
 }
 
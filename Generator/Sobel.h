@@ -5,6 +5,13 @@
 
 #include "../Image/Image.h"
 
-void Sobel_applySobelEdgeDetection(Image* img, bool normalize, float threshold);
+// Edge magnitudes of rows [first, first + count) of the gray `img` into `out`
+// (rows `out_stride` bytes apart); rows clamp at the top and bottom of `img`,
+// so a band with one row of halo above and below gives the same rows as the
+// whole image. Returns the largest magnitude.
+float Sobel_edgeRows(const Image* img, int first, int count, uint8_t* out, size_t out_stride);
+
+// `scratch` must hold width * height bytes, or be NULL to allocate one
+void Sobel_applySobelEdgeDetection(Image* img, bool normalize, float threshold, unsigned char* scratch);
 
 #endif // SOBEL.H
@@ -0,0 +1,33 @@
+#include "Subpixel.h"
+
+// U+2800 + mask encodes as E2 A0|(mask >> 6) 80|(mask & 0x3F)
+#define BRAILLE(m)    { { 0xE2, 0xA0 | ((m) >> 6), 0x80 | ((m) & 0x3F) }, 3 }
+#define BRAILLE4(m)   BRAILLE(m), BRAILLE((m) + 1), BRAILLE((m) + 2), BRAILLE((m) + 3)
+#define BRAILLE16(m)  BRAILLE4(m), BRAILLE4((m) + 4), BRAILLE4((m) + 8), BRAILLE4((m) + 12)
+#define BRAILLE64(m)  BRAILLE16(m), BRAILLE16((m) + 16), BRAILLE16((m) + 32), BRAILLE16((m) + 48)
+
+const UTF8Glyph SUBPIXEL_BRAILLE_GLYPHS[256] = {
+    BRAILLE64(0), BRAILLE64(64), BRAILLE64(128), BRAILLE64(192)
+};
+
+// U+1FB00 + k encodes as F0 9F AC 80|k (k < 60)
+#define SEXTANT(k)    { { 0xF0, 0x9F, 0xAC, 0x80 | (k) }, 4 }
+
+const UTF8Glyph SUBPIXEL_SEXTANT_GLYPHS[64] = {
+    { { 0x20 }, 1 }, SEXTANT(0x00), SEXTANT(0x01), SEXTANT(0x02),
+    SEXTANT(0x03), SEXTANT(0x04), SEXTANT(0x05), SEXTANT(0x06),
+    SEXTANT(0x07), SEXTANT(0x08), SEXTANT(0x09), SEXTANT(0x0A),
+    SEXTANT(0x0B), SEXTANT(0x0C), SEXTANT(0x0D), SEXTANT(0x0E),
+    SEXTANT(0x0F), SEXTANT(0x10), SEXTANT(0x11), SEXTANT(0x12),
+    SEXTANT(0x13), { { 0xE2, 0x96, 0x8C }, 3 }, SEXTANT(0x14), SEXTANT(0x15),
+    SEXTANT(0x16), SEXTANT(0x17), SEXTANT(0x18), SEXTANT(0x19),
+    SEXTANT(0x1A), SEXTANT(0x1B), SEXTANT(0x1C), SEXTANT(0x1D),
+    SEXTANT(0x1E), SEXTANT(0x1F), SEXTANT(0x20), SEXTANT(0x21),
+    SEXTANT(0x22), SEXTANT(0x23), SEXTANT(0x24), SEXTANT(0x25),
+    SEXTANT(0x26), SEXTANT(0x27), { { 0xE2, 0x96, 0x90 }, 3 }, SEXTANT(0x28),
+    SEXTANT(0x29), SEXTANT(0x2A), SEXTANT(0x2B), SEXTANT(0x2C),
+    SEXTANT(0x2D), SEXTANT(0x2E), SEXTANT(0x2F), SEXTANT(0x30),
+    SEXTANT(0x31), SEXTANT(0x32), SEXTANT(0x33), SEXTANT(0x34),
+    SEXTANT(0x35), SEXTANT(0x36), SEXTANT(0x37), SEXTANT(0x38),
+    SEXTANT(0x39), SEXTANT(0x3A), SEXTANT(0x3B), { { 0xE2, 0x96, 0x88 }, 3 },
+};
@@ -0,0 +1,45 @@
+#ifndef SUBPIXEL_H
+#define SUBPIXEL_H
+
+#include <stdint.h>
+
+// Sub-cell layout of the supported unicode block modes
+#define SUBPIXEL_BRAILLE_COLS 2
+#define SUBPIXEL_BRAILLE_ROWS 4
+#define SUBPIXEL_SEXTANT_COLS 2
+#define SUBPIXEL_SEXTANT_ROWS 3
+
+// Samples darker than this luminance are drawn as dots/blocks
+#define SUBPIXEL_THRESHOLD 128.0f
+
+typedef struct UTF8Glyph {
+    unsigned char bytes[4];
+    unsigned char length;
+} UTF8Glyph;
+
+// Indexed by dot mask (see Subpixel_brailleBit), U+2800..U+28FF
+extern const UTF8Glyph SUBPIXEL_BRAILLE_GLYPHS[256];
+
+// Indexed by cell mask (see Subpixel_sextantBit), U+1FB00..U+1FB3B plus the
+// four masks that already exist as block elements (empty, left, right, full)
+extern const UTF8Glyph SUBPIXEL_SEXTANT_GLYPHS[64];
+
+// Braille numbers its dots column-major for the top 3 rows (1-3, 4-6) and
+// appends the fourth row afterwards (7, 8)
+static inline uint8_t Subpixel_brailleBit(int sx, int sy) {
+    static const uint8_t BRAILLE_BITS[SUBPIXEL_BRAILLE_ROWS][SUBPIXEL_BRAILLE_COLS] = {
+        { 0x01, 0x08 },
+        { 0x02, 0x10 },
+        { 0x04, 0x20 },
+        { 0x40, 0x80 }
+    };
+
+    return BRAILLE_BITS[sy][sx];
+}
+
+// Sextants are numbered row-major, left to right and top to bottom
+static inline uint8_t Subpixel_sextantBit(int sx, int sy) {
+    return (uint8_t)(1u << (sy * SUBPIXEL_SEXTANT_COLS + sx));
+}
+
+#endif // SUBPIXEL_H
@@ -0,0 +1,111 @@
+#include "EventLoop.h"
+
+#include <fcntl.h>
+
+static void _drainWake(EventLoop* loop, EventSource* source, uint32_t events) {
+    uint64_t count;
+    while (read(source->fd, &count, sizeof(count)) < 0 && errno == EINTR)
+        ;
+
+    if (loop->on_wake)
+        loop->on_wake(loop, source, events);
+}
+
+bool EventLoop_init(EventLoop* loop, EventHandler on_wake, void* wake_data) {
+    memset(loop, 0, sizeof(EventLoop));
+    loop->wake.fd = -1;
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) {
+        fprintf(stderr, "EventLoop: epoll_create1 failed: %s.\n", strerror(errno));
+        return false;
+    }
+
+    loop->wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->wake.fd < 0) {
+        fprintf(stderr, "EventLoop: eventfd failed: %s.\n", strerror(errno));
+        EventLoop_release(loop);
+        return false;
+    }
+
+    loop->wake.handler = _drainWake;
+    loop->wake.data = wake_data;
+    loop->on_wake = on_wake;
+
+    if (!EventLoop_add(loop, &loop->wake, EPOLLIN)) {
+        EventLoop_release(loop);
+        return false;
+    }
+
+    return true;
+}
+
+void EventLoop_release(EventLoop* loop) {
+    if (loop->wake.fd >= 0) close(loop->wake.fd);
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+
+    loop->wake.fd = -1;
+    loop->epoll_fd = -1;
+}
+
+static inline bool _control(EventLoop* loop, int op, EventSource* source, uint32_t events) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.ptr = source;
+
+    if (epoll_ctl(loop->epoll_fd, op, source->fd, &event) != 0) {
+        fprintf(stderr, "EventLoop: epoll_ctl failed for fd %d: %s.\n", source->fd, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool EventLoop_add(EventLoop* loop, EventSource* source, uint32_t events) {
+    return _control(loop, EPOLL_CTL_ADD, source, events);
+}
+
+bool EventLoop_modify(EventLoop* loop, EventSource* source, uint32_t events) {
+    return _control(loop, EPOLL_CTL_MOD, source, events);
+}
+
+void EventLoop_remove(EventLoop* loop, EventSource* source) {
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
+}
+
+void EventLoop_wake(EventLoop* loop) {
+    uint64_t one = 1;
+    while (write(loop->wake.fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+}
+
+void EventLoop_stop(EventLoop* loop) {
+    loop->stopped = true;
+}
+
+int EventLoop_run(EventLoop* loop, const sigset_t* wait_mask) {
+    struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+
+    loop->stopped = false;
+    while (!loop->stopped) {
+        int ready = epoll_pwait(loop->epoll_fd, events, EVENTLOOP_MAX_EVENTS, -1, wait_mask);
+        if (ready < 0) {
+            if (errno == EINTR) return EINTR;
+            fprintf(stderr, "EventLoop: epoll_wait failed: %s.\n", strerror(errno));
+            return errno;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            EventSource* source = events[i].data.ptr;
+            source->handler(loop, source, events[i].events);
+        }
+    }
+
+    return 0;
+}
+
+bool EventLoop_setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
@@ -0,0 +1,60 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define EVENTLOOP_MAX_EVENTS 64
+
+typedef struct EventLoop EventLoop;
+typedef struct EventSource EventSource;
+
+typedef void (*EventHandler)(EventLoop* loop, EventSource* source, uint32_t events);
+
+// A registered descriptor; embed it in the owning object and recover the
+// object from the pointer the handler gets. It must outlive its registration.
+struct EventSource {
+    int fd;
+    EventHandler handler;
+    void* data;
+};
+
+// Single-threaded epoll loop. Other threads hand work back to it with
+// EventLoop_wake, which runs `on_wake` on the loop thread.
+struct EventLoop {
+    int epoll_fd;
+    EventSource wake;           // eventfd, `data` is the wake_data of EventLoop_init
+    EventHandler on_wake;
+    bool stopped;
+};
+
+bool EventLoop_init(EventLoop* loop, EventHandler on_wake, void* wake_data);
+void EventLoop_release(EventLoop* loop);
+
+bool EventLoop_add(EventLoop* loop, EventSource* source, uint32_t events);
+bool EventLoop_modify(EventLoop* loop, EventSource* source, uint32_t events);
+void EventLoop_remove(EventLoop* loop, EventSource* source);
+
+// Thread-safe; coalesces, so `on_wake` must drain everything pending
+void EventLoop_wake(EventLoop* loop);
+
+// Makes EventLoop_run return after the current round of events
+void EventLoop_stop(EventLoop* loop);
+
+// Dispatches events until EventLoop_stop (returns 0) or until a signal left
+// unblocked by `wait_mask` arrives (returns EINTR); other errno on failure.
+// `wait_mask` may be NULL to keep the current mask.
+int EventLoop_run(EventLoop* loop, const sigset_t* wait_mask);
+
+// Switches `fd` to non-blocking mode
+bool EventLoop_setNonBlocking(int fd);
+
+#endif // EVENTLOOP_H
@@ -0,0 +1,84 @@
+#include "Queue.h"
+
+bool Queue_init(Queue* queue, size_t capacity) {
+    memset(queue, 0, sizeof(Queue));
+
+    queue->items = malloc((capacity > 0 ? capacity : 1) * sizeof(void*));
+    if (!queue->items) {
+        fprintf(stderr, "Queue: failed to allocate %zu slots.\n", capacity);
+        return false;
+    }
+
+    queue->capacity = capacity > 0 ? capacity : 1;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+
+    return true;
+}
+
+void Queue_destroy(Queue* queue) {
+    if (!queue->items) return;
+
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+
+    memset(queue, 0, sizeof(Queue));
+}
+
+static inline void _append(Queue* queue, void* item) {
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+}
+
+bool Queue_push(Queue* queue, void* item) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity && !queue->closed)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    bool accepted = !queue->closed;
+    if (accepted)
+        _append(queue, item);
+    pthread_mutex_unlock(&queue->lock);
+
+    return accepted;
+}
+
+bool Queue_tryPush(Queue* queue, void* item) {
+    pthread_mutex_lock(&queue->lock);
+
+    bool accepted = !queue->closed && queue->count < queue->capacity;
+    if (accepted)
+        _append(queue, item);
+    pthread_mutex_unlock(&queue->lock);
+
+    return accepted;
+}
+
+void* Queue_pop(Queue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    void* item = NULL;
+    if (queue->count > 0) {
+        item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return item;
+}
+
+void Queue_close(Queue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
@@ -0,0 +1,39 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+// Bounded multi-producer multi-consumer FIFO of pointers.
+// A full queue blocks its producers, which is what bounds the memory held by
+// a pipeline: a stage can only run ahead of the next one by `capacity` items.
+typedef struct Queue {
+    void** items;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    bool closed;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} Queue;
+
+bool Queue_init(Queue* queue, size_t capacity);
+void Queue_destroy(Queue* queue);
+
+// Blocks while the queue is full; returns false once it is closed
+bool Queue_push(Queue* queue, void* item);
+
+// Returns false instead of blocking when the queue is full or closed
+bool Queue_tryPush(Queue* queue, void* item);
+
+// Blocks while the queue is empty; returns NULL once it is closed and drained
+void* Queue_pop(Queue* queue);
+
+// Wakes every waiter; items already queued can still be popped
+void Queue_close(Queue* queue);
+
+#endif // QUEUE_H
@@ -1,5 +1,13 @@
 #include "Image.h"
 
+// stb allocations count toward the render stats of the calling thread
+#define STBI_MALLOC(sz)        (Stats_countAllocations(1), malloc(sz))
+#define STBI_REALLOC(p, newsz) (Stats_countAllocations(1), realloc(p, newsz))
+#define STBI_FREE(p)           free(p)
+#define STBIW_MALLOC(sz)        (Stats_countAllocations(1), malloc(sz))
+#define STBIW_REALLOC(p, newsz) (Stats_countAllocations(1), realloc(p, newsz))
+#define STBIW_FREE(p)           free(p)
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "../stb_image/stb_image.h"
 
@@ -15,12 +23,60 @@ static inline bool _strEndsWith(const char* str, const char* ends) {
     return (pos != NULL) && (pos + ends_len == str + str_len);
 }
 
+// Unpadded rows, as decoders write them
+static inline void _setInterleaved(Image* img) {
+    img->layout = IMAGE_INTERLEAVED;
+    img->stride = (size_t)img->width * img->channels;
+    for (int c = 0; c < 4; c++)
+        img->planes[c] = NULL;
+}
+
+// Rows a multiple of 4 KiB apart all land in the same cache sets, so a block
+// read down a column of such rows keeps evicting itself; those get a line more
+static inline size_t _paddedStride(size_t bytes) {
+    size_t stride = (bytes + IMAGE_ALIGNMENT - 1) & ~(size_t)(IMAGE_ALIGNMENT - 1);
+    return (stride % 4096 == 0) ? stride + IMAGE_ALIGNMENT : stride;
+}
+
+// Sets the size and padded stride of a width x height x channels image to
+// create, or reports why there is none
+static bool _setPadded(Image* img, int width, int height, int channels, ImageLayout layout) {
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        fprintf(stderr, "Invalid image size %dx%d with %d channels\n", width, height, channels);
+        return false;
+    }
+
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->layout = layout;
+    img->stride = _paddedStride(layout == IMAGE_PLANAR ? (size_t)width : (size_t)width * channels);
+
+    size_t rows = (size_t)height * (layout == IMAGE_PLANAR ? channels : 1);
+    if (rows > (SIZE_MAX - IMAGE_ALIGNMENT) / img->stride) {
+        fprintf(stderr, "Image of %dx%d is too large\n", width, height);
+        return false;
+    }
+    img->size = img->stride * rows;
+
+    for (int c = 0; c < 4; c++)
+        img->planes[c] = NULL;
+    return true;
+}
+
+// Points the planes of a planar image into its data, back to back
+static inline void _setPlanes(Image* img) {
+    for (int c = 0; c < 4; c++)
+        img->planes[c] = (c < img->channels) ? img->data + (size_t)c * img->stride * img->height : NULL;
+}
+
 Image* Image_load(const char *filename) {
     if (access(filename, F_OK) != 0) {
         fprintf(stderr, "File %s does not exist\n", filename);
         return NULL;
     }
 
+    Stats_countAllocations(1);
     Image* out = malloc(sizeof(Image));
     if (!out) {
         fprintf(stderr, "Error allocating memory for image\n");
@@ -33,47 +89,281 @@ Image* Image_load(const char *filename) {
         return NULL;
     }
 
-    out->size = out->width * out->height * out->channels;
+    out->size = (size_t)out->width * out->height * out->channels;
     out->allocationType = STB_ALLOCATED;
+    _setInterleaved(out);
 
     return out; 
 }
 
-Image* Image_create(int width, int height, int channels, bool zeroed) {
-    size_t size = width * height * channels;
-    
+Image* Image_loadFromMemory(const unsigned char* bytes, size_t length) {
+    if (length > INT_MAX) {
+        fprintf(stderr, "Encoded image is too large\n");
+        return NULL;
+    }
+
+    Stats_countAllocations(1);
     Image* out = malloc(sizeof(Image));
     if (!out) {
         fprintf(stderr, "Error allocating memory for image\n");
         return NULL;
     }
 
-    out->data = (zeroed) ? calloc(size, 1) : malloc(size);
+    out->data = stbi_load_from_memory(bytes, (int)length, &out->width, &out->height, &out->channels, 0);
+    if (!out->data) {
+        fprintf(stderr, "Error decoding image from memory\n");
+        free(out);
+        return NULL;
+    }
+
+    out->size = (size_t)out->width * out->height * out->channels;
+    out->allocationType = STB_ALLOCATED;
+    _setInterleaved(out);
+
+    return out;
+}
+
+// Replaces the decoded pixels of `img` with their planar copy
+static bool _splitDecoded(Image* img) {
+    Image planar;
+    if (!_setPadded(&planar, img->width, img->height, img->channels, IMAGE_PLANAR))
+        return false;
+
+    Stats_countAllocations(1);
+    planar.data = aligned_alloc(IMAGE_ALIGNMENT, planar.size + IMAGE_ALIGNMENT);
+    if (!planar.data) {
+        fprintf(stderr, "Error allocating memory for image planes\n");
+        return false;
+    }
+    _setPlanes(&planar);
+    planar.allocationType = SELF_ALLOCATED;
+
+    Image_toPlanarInto(img, &planar);
+    stbi_image_free(img->data);
+    *img = planar;
+
+    return true;
+}
+
+Image* Image_loadAs(const char* filename, ImageLayout layout) {
+    Image* img = Image_load(filename);
+    if (img && layout == IMAGE_PLANAR && img->channels >= 3 && !_splitDecoded(img)) {
+        Image_free(img);
+        free(img);
+        return NULL;
+    }
+
+    return img;
+}
+
+Image* Image_loadFromMemoryAs(const unsigned char* bytes, size_t length, ImageLayout layout) {
+    Image* img = Image_loadFromMemory(bytes, length);
+    if (img && layout == IMAGE_PLANAR && img->channels >= 3 && !_splitDecoded(img)) {
+        Image_free(img);
+        free(img);
+        return NULL;
+    }
+
+    return img;
+}
+
+bool Image_readDimensions(const unsigned char* bytes, size_t length, int* width, int* height) {
+    if (length > INT_MAX) return false;
+
+    int channels;
+    return stbi_info_from_memory(bytes, (int)length, width, height, &channels) != 0;
+}
+
+// Planar buffers get IMAGE_ALIGNMENT bytes of slack after the last plane; the
+// allocation stays a multiple of the alignment, as aligned_alloc wants
+static Image* _create(int width, int height, int channels, ImageLayout layout, bool zeroed) {
+    Image shape;
+    if (!_setPadded(&shape, width, height, channels, layout))
+        return NULL;
+    size_t slack = (layout == IMAGE_PLANAR) ? IMAGE_ALIGNMENT : 0;
+
+    Stats_countAllocations(1);
+    Image* out = malloc(sizeof(Image));
+    if (!out) {
+        fprintf(stderr, "Error allocating memory for image\n");
+        return NULL;
+    }
+    *out = shape;
+
+    Stats_countAllocations(1);
+    out->data = aligned_alloc(IMAGE_ALIGNMENT, out->size + slack);
     if (!out->data) {
         fprintf(stderr, "Error allocating memory for image data\n");
+        free(out);
         return NULL;
     }
+    if (zeroed) memset(out->data, 0, out->size);
 
-    out->width = width;
-    out->height = height;
-    out->channels = channels;
+    if (layout == IMAGE_PLANAR) _setPlanes(out);
     out->allocationType = SELF_ALLOCATED;
 
     return out;
 }
 
+static Image* _createInArena(Arena* arena, int width, int height, int channels, ImageLayout layout, bool zeroed) {
+    Image shape;
+    if (!_setPadded(&shape, width, height, channels, layout))
+        return NULL;
+    size_t slack = (layout == IMAGE_PLANAR) ? IMAGE_ALIGNMENT : 0;
+
+    Image* out = Arena_alloc(arena, sizeof(Image), _Alignof(Image));
+    if (!out) {
+        fprintf(stderr, "Error allocating memory for image\n");
+        return NULL;
+    }
+    *out = shape;
+
+    out->data = (zeroed) ? Arena_calloc(arena, out->size + slack, IMAGE_ALIGNMENT)
+                         : Arena_alloc(arena, out->size + slack, IMAGE_ALIGNMENT);
+    if (!out->data) {
+        fprintf(stderr, "Error allocating memory for image data\n");
+        return NULL;
+    }
+
+    if (layout == IMAGE_PLANAR) _setPlanes(out);
+    out->allocationType = ARENA_ALLOCATED;
+
+    return out;
+}
+
+Image* Image_create(int width, int height, int channels, bool zeroed) {
+    return _create(width, height, channels, IMAGE_INTERLEAVED, zeroed);
+}
+
+Image* Image_createInArena(Arena* arena, int width, int height, int channels, bool zeroed) {
+    return _createInArena(arena, width, height, channels, IMAGE_INTERLEAVED, zeroed);
+}
+
+Image* Image_createPlanar(int width, int height, int channels) {
+    return _create(width, height, channels, IMAGE_PLANAR, false);
+}
+
+Image* Image_createPlanarInArena(Arena* arena, int width, int height, int channels) {
+    return _createInArena(arena, width, height, channels, IMAGE_PLANAR, false);
+}
+
+bool Image_view(const Image* img, ImageRect rect, Image* view) {
+    if (!Image_rectInside(rect, img->width, img->height)) {
+        fprintf(stderr, "View %dx%d at %d,%d is not inside the %dx%d image\n",
+                rect.width, rect.height, rect.x, rect.y, img->width, img->height);
+        return false;
+    }
+
+    *view = *img;
+    view->width = rect.width;
+    view->height = rect.height;
+    view->size = 0;
+    view->allocationType = BORROWED;
+
+    if (img->layout == IMAGE_PLANAR) {
+        for (int c = 0; c < img->channels; c++)
+            view->planes[c] = img->planes[c] + (size_t)rect.y * img->stride + rect.x;
+        view->data = view->planes[0];
+    } else {
+        view->data = Image_row(img, rect.y) + (size_t)rect.x * img->channels;
+    }
+
+    return true;
+}
+
+void Image_toPlanarInto(const Image* original, Image* planar) {
+    const Kernels* kernels = Kernels_get();
+
+    for (int y = 0; y < original->height; y++) {
+        uint8_t* rows[4] = { NULL, NULL, NULL, NULL };
+        for (int c = 0; c < original->channels; c++)
+            rows[c] = planar->planes[c] + (size_t)y * planar->stride;
+
+        kernels->deinterleave(Image_row(original, y), original->channels, rows, (size_t)original->width);
+    }
+}
+
+// Pointer to the pixels of `img` without row padding, a copy the caller
+// frees when the rows are padded; NULL when out of memory
+static const uint8_t* _packedPixels(const Image* img) {
+    size_t row = (size_t)img->width * img->channels;
+    if (img->stride == row) return img->data;
+
+    Stats_countAllocations(1);
+    uint8_t* packed = malloc(row * img->height);
+    if (!packed) return NULL;
+
+    for (int y = 0; y < img->height; y++)
+        memcpy(packed + (size_t)y * row, Image_row(img, y), row);
+    return packed;
+}
+
+// stb_image_write sizes PNG buffers in int, from the stride and from each row
+// plus its filter byte, so larger images would overflow
+static inline bool _fitsPNGWriter(const Image* img) {
+    size_t row = (size_t)img->width * img->channels + 1;
+    if (img->stride > row) row = img->stride;
+
+    if ((size_t)img->height > (size_t)INT_MAX / row) {
+        fprintf(stderr, "Image %dx%d is too large to encode as PNG\n", img->width, img->height);
+        return false;
+    }
+    return true;
+}
+
 // TODO: add more extensions
 void Image_save(const Image *img, const char *filename) {
+    if (img->layout != IMAGE_INTERLEAVED) {
+        fprintf(stderr, "Unable to save planar image %s\n", filename);
+        return;
+    }
+
     if (_strEndsWith(filename, ".jpg") || _strEndsWith(filename, ".JPG") || _strEndsWith(filename, ".jpeg") || _strEndsWith(filename, ".JPEG")) {
-        stbi_write_jpg(filename, img->width, img->height, img->channels, img->data, 100);
+        // the JPEG writer takes no stride
+        const uint8_t* pixels = _packedPixels(img);
+        if (!pixels) {
+            fprintf(stderr, "Error allocating memory to save image %s\n", filename);
+            return;
+        }
+        stbi_write_jpg(filename, img->width, img->height, img->channels, pixels, 100);
+        if (pixels != img->data) free((void*)pixels);
     } else if (_strEndsWith(filename, ".png") || _strEndsWith(filename, ".PNG")) {
-        stbi_write_png(filename, img->width, img->height, img->channels, img->data, img->width * img->channels);
+        if (!_fitsPNGWriter(img)) return;
+        stbi_write_png(filename, img->width, img->height, img->channels, img->data, (int)img->stride);
     } else {
         fprintf(stderr, "Image type not recognized. Unable to save image %s\n", filename);
         exit(EXIT_FAILURE);
     }
 }
 
+static void _writeToFile(void* context, void* data, int size) {
+    fwrite(data, 1, size, (FILE*)context);
+}
+
+bool Image_writePNG(const Image* img, FILE* file) {
+    if (img->layout != IMAGE_INTERLEAVED || !_fitsPNGWriter(img)) return false;
+
+    return stbi_write_png_to_func(_writeToFile, file, img->width, img->height, img->channels, img->data, (int)img->stride) != 0;
+}
+
+unsigned char* Image_encodePNG(const Image* img, size_t* length) {
+    if (img->layout != IMAGE_INTERLEAVED) {
+        fprintf(stderr, "Error encoding PNG: planar image\n");
+        return NULL;
+    }
+    if (!_fitsPNGWriter(img)) return NULL;
+
+    int len = 0;
+    unsigned char* png = stbi_write_png_to_mem(img->data, (int)img->stride, img->width, img->height, img->channels, &len);
+    if (!png) {
+        fprintf(stderr, "Error encoding PNG\n");
+        return NULL;
+    }
+
+    *length = (size_t)len;
+    return png;
+}
+
 void Image_free(Image* img) {
     if (img->allocationType == NO_ALLOCATION || img->data == NULL) {
         fprintf(stderr, "Image not allocated\n");
@@ -82,14 +372,16 @@ void Image_free(Image* img) {
 
     if (img->allocationType == STB_ALLOCATED)
         stbi_image_free(img->data);
-    else
+    else if (img->allocationType == SELF_ALLOCATED)
         free(img->data);
+    // ARENA_ALLOCATED data goes away with the arena, BORROWED data with its owner
 
     img->data = NULL;
     img->width = 0;
     img->height = 0;
     img->size = 0;
     img->allocationType = NO_ALLOCATION;
+    _setInterleaved(img);
 }
 
 Image* Image_toGrayscale(const Image* original, GrayscaleMethod method) {
@@ -100,36 +392,40 @@ Image* Image_toGrayscale(const Image* original, GrayscaleMethod method) {
         return NULL;
     }
 
+    Image_toGrayscaleInto(original, grayImg, method);
+
+    return grayImg;
+}
+
+static void _toGrayscale(const Image* original, Image* grayImg, KernelGray mode) {
+    const Kernels* kernels = Kernels_get();
+    size_t width = (size_t)original->width;
+
+    // unpadded images convert in one call, padded ones a row at a time
+    if (original->layout == IMAGE_INTERLEAVED && original->stride == width * original->channels && grayImg->stride == width) {
+        kernels->grayscale(original->data, original->channels, grayImg->data, width * original->height, mode);
+        return;
+    }
+
     for (int y = 0; y < original->height; y++) {
-        for (int x = 0; x < original->width; x++) {
-            int pixel_index = (y * original->width + x) * original->channels;
-            
-            unsigned char r = original->data[pixel_index];
-            unsigned char g = original->data[pixel_index + 1];
-            unsigned char b = original->data[pixel_index + 2];
-        
-            
-            if (original->channels == 4) {
-                unsigned char a = original->data[pixel_index + 3];
-                if (a < 128) {
-                    grayImg->data[y * original->width + x] = 0;
-                } else {
-                    if (method == GRAY_AVERAGE) {
-                        grayImg->data[y * original->width + x] = (r + g + b) / 3.0f;
-                    } else {
-                        grayImg->data[y * original->width + x] = (0.2126f * r) + (0.7152 * g) + (0.0722 * b);
-                    }
-                }               
-            } else {
-                if (method == GRAY_AVERAGE) {
-                    grayImg->data[y * original->width + x] = (r + g + b) / 3.0f;
-                } else {
-                    grayImg->data[y * original->width + x] = (0.2126f * r) + (0.7152 * g) + (0.0722 * b);
-                }
-            }
+        uint8_t* dst = Image_row(grayImg, y);
+        if (original->layout == IMAGE_INTERLEAVED) {
+            kernels->grayscale(Image_row(original, y), original->channels, dst, width, mode);
+            continue;
         }
+
+        const uint8_t* rows[4] = { NULL, NULL, NULL, NULL };
+        for (int c = 0; c < original->channels; c++)
+            rows[c] = original->planes[c] + (size_t)y * original->stride;
+        kernels->grayscalePlanar(rows, original->channels, dst, width, mode);
     }
+}
 
-    return grayImg;
+void Image_toGrayscaleInto(const Image* original, Image* grayImg, GrayscaleMethod method) {
+    _toGrayscale(original, grayImg, method == GRAY_AVERAGE ? KERNEL_GRAY_AVERAGE : KERNEL_GRAY_LUMINANCE);
+}
+
+void Image_toGrayscaleFixedInto(const Image* original, Image* grayImg, GrayscaleMethod method) {
+    _toGrayscale(original, grayImg, method == GRAY_AVERAGE ? KERNEL_GRAY_AVERAGE : KERNEL_GRAY_LUMINANCE_FIXED);
 }
 
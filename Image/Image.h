@@ -1,12 +1,17 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "../Arena/Arena.h"
+#include "../Kernels/Kernels.h"
+
 typedef enum GrayscaleMethod {
     GRAY_AVERAGE,
     GRAY_LUMINANCE
@@ -15,26 +20,99 @@ typedef enum GrayscaleMethod {
 typedef enum AllocationType {
     NO_ALLOCATION,
     SELF_ALLOCATED,
-    STB_ALLOCATED
+    STB_ALLOCATED,
+    ARENA_ALLOCATED,    // struct and data live in an Arena, released by Arena_reset
+    BORROWED            // a view into the pixels of another image, which must outlive it
 } AllocationType;
 
+typedef enum ImageLayout {
+    IMAGE_INTERLEAVED,  // the channels of a pixel are adjacent
+    IMAGE_PLANAR        // one plane per channel
+} ImageLayout;
+
+// A width x height block of an image whose top-left pixel is (x, y)
+typedef struct ImageRect {
+    int x;
+    int y;
+    int width;
+    int height;
+} ImageRect;
+
+// Buffers created here start on, and pad their rows to, this many bytes; as
+// much again follows planar buffers so vector loads can overrun any row.
+// Decoded images keep the decoder's unpadded rows.
+#define IMAGE_ALIGNMENT 64
+
 typedef struct Image {
     int width;
     int height;
     int channels;
-    size_t size;
+    size_t size;            // bytes owned by data, row padding included
     uint8_t* data;
     AllocationType allocationType;
+    ImageLayout layout;
+    size_t stride;          // bytes between the starts of two rows (of a plane when planar)
+    uint8_t* planes[4];     // planar only: first row of each channel
 } Image;
 
-static inline bool _strEndsWith(const char* str, const char* ends);
+// First byte of row y of an interleaved image (of the first plane when planar)
+static inline uint8_t* Image_row(const Image* img, int y) {
+    return img->data + (size_t)y * img->stride;
+}
+
+// True when `rect` is not empty and lies inside a width x height image
+static inline bool Image_rectInside(ImageRect rect, int width, int height) {
+    return rect.x >= 0 && rect.y >= 0 && rect.width > 0 && rect.height > 0 &&
+           rect.x <= width - rect.width && rect.y <= height - rect.height;
+}
 
 Image* Image_load(const char* filename);
+
+// Decodes an encoded image (PNG, JPEG, ...) that is already in memory
+Image* Image_loadFromMemory(const unsigned char* bytes, size_t length);
+
+// Image_load and Image_loadFromMemory into either layout; planar images are
+// split from the decoder's buffer, which is then freed. Gray and gray + alpha
+// images stay interleaved.
+Image* Image_loadAs(const char* filename, ImageLayout layout);
+Image* Image_loadFromMemoryAs(const unsigned char* bytes, size_t length, ImageLayout layout);
+
+// Reads the dimensions from the header of an encoded image without decoding it
+bool Image_readDimensions(const unsigned char* bytes, size_t length, int* width, int* height);
+
+// Interleaved images with IMAGE_ALIGNMENT aligned rows; NULL (with an error)
+// for sizes that are not positive or do not fit in memory
 Image* Image_create(int width, int height, int channels, bool zeroed);
+Image* Image_createInArena(Arena* arena, int width, int height, int channels, bool zeroed);
+
+// Uninitialized planar images; every plane and row starts IMAGE_ALIGNMENT aligned
+Image* Image_createPlanar(int width, int height, int channels);
+Image* Image_createPlanarInArena(Arena* arena, int width, int height, int channels);
+
+// Fills `view` with the block `rect` of `img`, sharing its pixels; false
+// (with an error) when the block is empty or not inside the image. Views are
+// BORROWED, Image_free only clears them.
+bool Image_view(const Image* img, ImageRect rect, Image* view);
 
+// Splits the interleaved `original` into `planar`, created with the same size and channels
+void Image_toPlanarInto(const Image* original, Image* planar);
+
+// The writers take interleaved images only
 void Image_save(const Image* img, const char* filename);
+bool Image_writePNG(const Image* img, FILE* file);
+
+// Encodes `img` as PNG into a malloc'd buffer the caller frees
+unsigned char* Image_encodePNG(const Image* img, size_t* length);
 void Image_free(Image* img);
 
 Image* Image_toGrayscale(const Image* original, GrayscaleMethod method);
 
+// Same as Image_toGrayscale but writes into `gray`, an image created with the
+// same width and height and one channel; `original` can be planar
+void Image_toGrayscaleInto(const Image* original, Image* gray, GrayscaleMethod method);
+
+// Same as Image_toGrayscaleInto with integer luminance weights, so the result
+// does not depend on the compiler's floating point
+void Image_toGrayscaleFixedInto(const Image* original, Image* gray, GrayscaleMethod method);
+
 #endif // IMAGE_H
@@ -0,0 +1,204 @@
+#include "Kernels.h"
+
+static Kernels kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static const char* LEVEL_NAMES[CPU_LEVEL_COUNT] = {
+    "scalar", "sse2", "sse4.1", "avx2", "avx512"
+};
+
+void Kernels_grayscaleScalar(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    // one and two channel images are gray already, possibly with alpha
+    if (channels < 3) {
+        for (size_t i = 0; i < count; i++, src += channels)
+            dst[i] = (channels == 2 && src[1] < 128) ? 0 : src[0];
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++, src += channels) {
+        if (channels == 4 && src[3] < 128) {
+            dst[i] = 0;
+        } else if (mode == KERNEL_GRAY_AVERAGE) {
+            dst[i] = (src[0] + src[1] + src[2]) / 3;
+        } else if (mode == KERNEL_GRAY_LUMINANCE_FIXED) {
+            dst[i] = Kernels_lumaFixed(src[0], src[1], src[2]);
+        } else {
+            dst[i] = (KERNELS_LUMA_R * src[0]) + (KERNELS_LUMA_G * src[1]) + (KERNELS_LUMA_B * src[2]);
+        }
+    }
+}
+
+void Kernels_grayscalePlanarScalar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    const uint8_t* r = planes[0];
+
+    if (channels < 3) {
+        const uint8_t* a = (channels == 2) ? planes[1] : NULL;
+        for (size_t i = 0; i < count; i++)
+            dst[i] = (a && a[i] < 128) ? 0 : r[i];
+        return;
+    }
+
+    const uint8_t* g = planes[1];
+    const uint8_t* b = planes[2];
+    const uint8_t* a = (channels == 4) ? planes[3] : NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        if (a && a[i] < 128) {
+            dst[i] = 0;
+        } else if (mode == KERNEL_GRAY_AVERAGE) {
+            dst[i] = (r[i] + g[i] + b[i]) / 3;
+        } else if (mode == KERNEL_GRAY_LUMINANCE_FIXED) {
+            dst[i] = Kernels_lumaFixed(r[i], g[i], b[i]);
+        } else {
+            dst[i] = (KERNELS_LUMA_R * r[i]) + (KERNELS_LUMA_G * g[i]) + (KERNELS_LUMA_B * b[i]);
+        }
+    }
+}
+
+void Kernels_deinterleaveScalar(const uint8_t* src, int channels, uint8_t* const planes[4], size_t count) {
+    for (size_t i = 0; i < count; i++, src += channels) {
+        for (int c = 0; c < channels; c++)
+            planes[c][i] = src[c];
+    }
+}
+
+uint64_t Kernels_sumBlockScalar(const uint8_t* data, size_t stride, int width, int height) {
+    uint64_t total = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        uint32_t row = 0;
+        for (int x = 0; x < width; x++)
+            row += data[x];
+        total += row;
+    }
+
+    return total;
+}
+
+void Kernels_sumBlockRGBScalar(const uint8_t* data, size_t stride, int width, int height, int channels, uint64_t sums[3]) {
+    sums[0] = sums[1] = sums[2] = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        const uint8_t* p = data;
+        for (int x = 0; x < width; x++, p += channels) {
+            sums[0] += p[0];
+            sums[1] += p[1];
+            sums[2] += p[2];
+        }
+    }
+}
+
+void Kernels_sumBlockPlanesScalar(const uint8_t* const planes[3], size_t stride, int width, int height, uint64_t sums[3]) {
+    for (int c = 0; c < 3; c++)
+        sums[c] = Kernels_sumBlockScalar(planes[c], stride, width, height);
+}
+
+int32_t Kernels_dotRowScalar(const uint8_t* data, const int16_t* weights, int count) {
+    int32_t sum = 0;
+    for (int x = 0; x < count; x++)
+        sum += weights[x] * data[x];
+    return sum;
+}
+
+float Kernels_sobelRowScalar(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, int width) {
+    return Kernels_sobelSpan(above, row, below, out, 0, width, width);
+}
+
+void Kernels_quantize16Scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = (uint8_t)Kernels_ansi16Index(r[i], g[i], b[i]);
+}
+
+void Kernels_quantize256Scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = (uint8_t)Kernels_ansi256Index(r[i], g[i], b[i]);
+}
+
+CpuLevel Kernels_detect(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    // also checks that the OS saves the wider registers
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return CPU_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return CPU_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return CPU_SSE41;
+    if (__builtin_cpu_supports("sse2"))
+        return CPU_SSE2;
+#endif
+
+    return CPU_SCALAR;
+}
+
+const char* Kernels_levelName(CpuLevel level) {
+    return (level >= 0 && level < CPU_LEVEL_COUNT) ? LEVEL_NAMES[level] : "unknown";
+}
+
+CpuLevel Kernels_levelFromName(const char* name) {
+    for (int i = 0; i < CPU_LEVEL_COUNT; i++) {
+        if (strcmp(name, LEVEL_NAMES[i]) == 0)
+            return (CpuLevel)i;
+    }
+
+    return CPU_LEVEL_COUNT;
+}
+
+static inline void _bind(Kernels* table, CpuLevel level) {
+    table->level = level;
+    table->grayscale = Kernels_grayscaleScalar;
+    table->grayscalePlanar = Kernels_grayscalePlanarScalar;
+    table->deinterleave = Kernels_deinterleaveScalar;
+    table->sumBlock = Kernels_sumBlockScalar;
+    table->sumBlockRGB = Kernels_sumBlockRGBScalar;
+    table->sumBlockPlanes = Kernels_sumBlockPlanesScalar;
+    table->dotRow = Kernels_dotRowScalar;
+    table->sobelRow = Kernels_sobelRowScalar;
+    table->quantize16 = Kernels_quantize16Scalar;
+    table->quantize256 = Kernels_quantize256Scalar;
+
+    // each level only replaces what it does better than the one below
+#if defined(__x86_64__) || defined(__i386__)
+    if (level >= CPU_SSE2)   Kernels_bindSSE2(table);
+    if (level >= CPU_SSE41)  Kernels_bindSSE41(table);
+    if (level >= CPU_AVX2)   Kernels_bindAVX2(table);
+    if (level >= CPU_AVX512) Kernels_bindAVX512(table);
+#endif
+}
+
+static void _init(void) {
+    CpuLevel level = Kernels_detect();
+
+    const char* requested = getenv(KERNELS_CPU_ENV);
+    if (requested && *requested) {
+        CpuLevel cap = Kernels_levelFromName(requested);
+        if (cap == CPU_LEVEL_COUNT) {
+            fprintf(stderr, "Kernels: unknown %s '%s', using %s.\n",
+                    KERNELS_CPU_ENV, requested, Kernels_levelName(level));
+        } else if (cap > level) {
+            fprintf(stderr, "Kernels: %s is not supported by this CPU, using %s.\n",
+                    requested, Kernels_levelName(level));
+        } else {
+            level = cap;
+        }
+    }
+
+    _bind(&kernels, level);
+}
+
+const Kernels* Kernels_get(void) {
+    pthread_once(&kernels_once, _init);
+    return &kernels;
+}
+
+CpuLevel Kernels_select(CpuLevel level) {
+    pthread_once(&kernels_once, _init);
+
+    CpuLevel supported = Kernels_detect();
+    if (level > supported) level = supported;
+
+    // not synchronized with renders in flight; select between runs
+    _bind(&kernels, level);
+    return level;
+}
@@ -0,0 +1,193 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+
+// Instruction set levels, each one implies the ones before it
+typedef enum CpuLevel {
+    CPU_SCALAR,
+    CPU_SSE2,
+    CPU_SSE41,
+    CPU_AVX2,
+    CPU_AVX512,     // AVX-512 F + BW
+    CPU_LEVEL_COUNT
+} CpuLevel;
+
+// Grayscale conversions of the grayscale kernel
+typedef enum KernelGray {
+    KERNEL_GRAY_AVERAGE,            // floor of the channel mean
+    KERNEL_GRAY_LUMINANCE,          // BT.709 in float, see KERNELS_LUMA_R
+    KERNEL_GRAY_LUMINANCE_FIXED     // BT.709 in integers, see KERNELS_LUMA_FIXED_R
+} KernelGray;
+
+// Environment variable capping the level (scalar, sse2, sse4.1, avx2, avx512),
+// so every path can be exercised on one machine
+#define KERNELS_CPU_ENV "GENSCII_CPU"
+
+// Bytes past the end of a row that sumBlockPlanes may load (and ignore)
+#define KERNELS_PLANE_SLACK 32
+
+// Inner loops of the pipeline. Every implementation of a kernel returns
+// exactly the same bytes as the scalar one, so the level never shows in the output.
+typedef struct Kernels {
+    CpuLevel level;
+
+    // `count` pixels of `channels` bytes to 8-bit gray; pixels with alpha < 128 become 0
+    void (*grayscale)(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode);
+
+    // Same as grayscale for `count` pixels split into one plane per channel
+    void (*grayscalePlanar)(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode);
+
+    // Splits `count` pixels of `channels` bytes into one plane per channel
+    void (*deinterleave)(const uint8_t* src, int channels, uint8_t* const planes[4], size_t count);
+
+    // Sum of a width x height block of an 8-bit plane, rows `stride` bytes apart
+    uint64_t (*sumBlock)(const uint8_t* data, size_t stride, int width, int height);
+
+    // Per-channel sums (first three channels) of a width x height block of
+    // interleaved pixels with 3 or 4 channels
+    void (*sumBlockRGB)(const uint8_t* data, size_t stride, int width, int height, int channels, uint64_t sums[3]);
+
+    // sumBlock of the same block of three planes; every row may be read up to
+    // KERNELS_PLANE_SLACK bytes past `width`, the extra bytes are masked off
+    void (*sumBlockPlanes)(const uint8_t* const planes[3], size_t stride, int width, int height, uint64_t sums[3]);
+
+    // Weighted sum of `count` bytes; the caller keeps the sum of the absolute
+    // weights times 255 within int32
+    int32_t (*dotRow)(const uint8_t* data, const int16_t* weights, int count);
+
+    // One output row of the 3x3 Sobel magnitude (clamped to 255) from the
+    // row and its neighbours; the caller clamps rows at the image border.
+    // Returns the largest magnitude before clamping.
+    float (*sobelRow)(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, int width);
+
+    // Nearest entries of the ANSI 16-color palette and the 256-color cube
+    void (*quantize16)(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count);
+    void (*quantize256)(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count);
+} Kernels;
+
+// Kernels for the best level of this CPU, detected on first use and capped by
+// KERNELS_CPU_ENV; safe to call from any thread
+const Kernels* Kernels_get(void);
+
+// Highest level the CPU and the OS support
+CpuLevel Kernels_detect(void);
+
+// Rebinds Kernels_get to `level` (capped to what the CPU supports) and
+// returns the level in effect; meant for benchmarks and tests
+CpuLevel Kernels_select(CpuLevel level);
+
+const char* Kernels_levelName(CpuLevel level);
+
+// Parses a Kernels_levelName; returns CPU_LEVEL_COUNT when unknown
+CpuLevel Kernels_levelFromName(const char* name);
+
+// Scalar reference implementations, also used for the tails of vector loops
+void Kernels_grayscaleScalar(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode);
+void Kernels_grayscalePlanarScalar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode);
+void Kernels_deinterleaveScalar(const uint8_t* src, int channels, uint8_t* const planes[4], size_t count);
+uint64_t Kernels_sumBlockScalar(const uint8_t* data, size_t stride, int width, int height);
+void Kernels_sumBlockRGBScalar(const uint8_t* data, size_t stride, int width, int height, int channels, uint64_t sums[3]);
+void Kernels_sumBlockPlanesScalar(const uint8_t* const planes[3], size_t stride, int width, int height, uint64_t sums[3]);
+int32_t Kernels_dotRowScalar(const uint8_t* data, const int16_t* weights, int count);
+float Kernels_sobelRowScalar(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, int width);
+void Kernels_quantize16Scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count);
+void Kernels_quantize256Scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count);
+
+// Overwrite the entries of `kernels` a level has vector versions of; only
+// defined on x86 (see KernelsSSE2.c and friends)
+void Kernels_bindSSE2(Kernels* kernels);
+void Kernels_bindSSE41(Kernels* kernels);
+void Kernels_bindAVX2(Kernels* kernels);
+void Kernels_bindAVX512(Kernels* kernels);
+
+static const uint8_t KERNELS_ANSI16_RGB[16][3] = {
+    {  0,   0,   0  }, { 128, 0,  0  }, { 0, 128,  0  }, { 128, 128,  0  },
+    {  0 ,  0,  128 }, { 128, 0, 128 }, { 0, 128, 128 }, { 192, 192, 192 },
+    { 128, 128, 128 }, { 255, 0,  0  }, { 0, 255,  0  }, { 255, 255,  0  },
+    {  0,   0,  255 }, { 255, 0, 255 }, { 0, 255, 255 }, { 255, 255, 255 }
+};
+
+// BT.709 weights exactly as the scalar code evaluates them: the red product
+// is rounded to float, the sum is done in double and truncated
+#define KERNELS_LUMA_R 0.2126f
+#define KERNELS_LUMA_G 0.7152
+#define KERNELS_LUMA_B 0.0722
+
+// The same weights in 1.15 fixed point, adding up to exactly 1 so gray
+// input maps to itself; the sum is truncated like the float version
+#define KERNELS_LUMA_FIXED_SHIFT 15
+#define KERNELS_LUMA_FIXED_R     6966
+#define KERNELS_LUMA_FIXED_G     23436
+#define KERNELS_LUMA_FIXED_B     2366
+
+static inline uint8_t Kernels_lumaFixed(uint8_t r, uint8_t g, uint8_t b) {
+    uint32_t sum = (uint32_t)r * KERNELS_LUMA_FIXED_R + (uint32_t)g * KERNELS_LUMA_FIXED_G + (uint32_t)b * KERNELS_LUMA_FIXED_B;
+    return (uint8_t)(sum >> KERNELS_LUMA_FIXED_SHIFT);
+}
+
+// Index of the color in the ANSI 16-color palette closest to (r, g, b);
+// ties go to the lower index
+static inline int Kernels_ansi16Index(uint8_t r, uint8_t g, uint8_t b) {
+    int best_index = 0;
+    int min_dist = INT_MAX;
+
+    for (int i = 0; i < 16; i++) {
+        int dr = r - KERNELS_ANSI16_RGB[i][0];
+        int dg = g - KERNELS_ANSI16_RGB[i][1];
+        int db = b - KERNELS_ANSI16_RGB[i][2];
+
+        int dist = dr*dr + dg*dg + db*db;
+
+        if (dist < min_dist) {
+            min_dist = dist;
+            best_index = i;
+        }
+    }
+
+    return best_index;
+}
+
+// Sobel magnitude at column x of a row, clamping columns at the borders.
+// The middle row of the horizontal kernel is { -2, 0, -2 }.
+static inline float Kernels_sobelAt(const uint8_t* above, const uint8_t* row, const uint8_t* below, int x, int width) {
+    int l = (x > 0) ? x - 1 : 0;
+    int r = (x < width - 1) ? x + 1 : width - 1;
+
+    int gx = -above[l] + above[r] - 2 * row[l] - 2 * row[r] - below[l] + below[r];
+    int gy = -above[l] - 2 * above[x] - above[r] + below[l] + 2 * below[x] + below[r];
+
+    // both squares and their sum are exact in float
+    return sqrtf((float)(gx * gx + gy * gy));
+}
+
+// Sobel row between columns `from` and `to` (exclusive) of a `width` row;
+// returns the largest magnitude of the span, or 0
+static inline float Kernels_sobelSpan(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                                      uint8_t* out, int from, int to, int width) {
+    float max_val = 0.0f;
+
+    for (int x = from; x < to; x++) {
+        float magnitude = Kernels_sobelAt(above, row, below, x, width);
+        if (magnitude > max_val)
+            max_val = magnitude;
+
+        out[x] = (uint8_t)fminf(magnitude, 255.0f);
+    }
+
+    return max_val;
+}
+
+// Index of (r, g, b) in the 6x6x6 color cube of the 256-color palette
+static inline int Kernels_ansi256Index(uint8_t r, uint8_t g, uint8_t b) {
+    return 16 + 36 * ((r * 6) >> 8) + 6 * ((g * 6) >> 8) + ((b * 6) >> 8);
+}
+
+#endif // KERNELS_H
@@ -0,0 +1,327 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC target("avx2")
+#endif
+
+#include "KernelsX86.h"
+
+// Adds the four 64-bit lanes of a vpsadbw accumulator
+static inline uint64_t _sum256(__m256i v) {
+    return _sum64(_mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+// Luminance of 4 pixels in the float and double steps of Kernels_grayscaleScalar
+KERNELS_INLINE __m128i _luminance4(__m128i r, __m128i g, __m128i b) {
+    __m128 red = _mm_mul_ps(_mm_cvtepi32_ps(r), _mm_set1_ps(KERNELS_LUMA_R));
+
+    __m256d sum = _mm256_add_pd(_mm256_cvtps_pd(red), _mm256_mul_pd(_mm256_cvtepi32_pd(g), _mm256_set1_pd(KERNELS_LUMA_G)));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_cvtepi32_pd(b), _mm256_set1_pd(KERNELS_LUMA_B)));
+
+    return _mm256_cvttpd_epi32(sum);
+}
+
+KERNELS_INLINE __m128i _luminance16(__m128i r, __m128i g, __m128i b) {
+    __m128i quarters[4];
+    for (int k = 0; k < 4; k++) {
+        quarters[k] = _luminance4(_mm_cvtepu8_epi32(r), _mm_cvtepu8_epi32(g), _mm_cvtepu8_epi32(b));
+        r = _mm_srli_si128(r, 4);
+        g = _mm_srli_si128(g, 4);
+        b = _mm_srli_si128(b, 4);
+    }
+
+    return _mm_packus_epi16(_mm_packs_epi32(quarters[0], quarters[1]), _mm_packs_epi32(quarters[2], quarters[3]));
+}
+
+KERNELS_INLINE __m128i _gray16(const __m128i planes[4], int channels, KernelGray mode) {
+    __m128i gray = (mode == KERNEL_GRAY_AVERAGE)         ? _average16(planes[0], planes[1], planes[2])
+                 : (mode == KERNEL_GRAY_LUMINANCE_FIXED) ? _lumaFixed16(planes[0], planes[1], planes[2])
+                                                         : _luminance16(planes[0], planes[1], planes[2]);
+    return (channels == 4) ? _applyAlpha(gray, planes[3]) : gray;
+}
+
+KERNELS_INLINE void _grayscale16(const uint8_t* src, int channels, uint8_t* dst, KernelGray mode) {
+    __m128i planes[4];
+    _deinterleave16(src, channels, planes);
+    _mm_storeu_si128((__m128i*)dst, _gray16(planes, channels, mode));
+}
+
+static void _grayscale(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels == 3) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 3 * i, 3, dst + i, mode);
+    } else if (channels == 4) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 4 * i, 4, dst + i, mode);
+    }
+
+    Kernels_grayscaleScalar(src + i * channels, channels, dst + i, count - i, mode);
+}
+
+static void _grayscalePlanar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels >= 3) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            _loadPlanes16(planes, channels, i, v);
+            _mm_storeu_si128((__m128i*)(dst + i), _gray16(v, channels, mode));
+        }
+    }
+
+    _grayscalePlanarTail(planes, channels, dst, count, i, mode);
+}
+
+static uint64_t _sumBlock(const uint8_t* data, size_t stride, int width, int height) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    __m128i acc128 = _mm_setzero_si128();
+    uint64_t tail = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(data + x)), zero));
+        if (x + 16 <= width) {
+            acc128 = _mm_add_epi64(acc128, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(data + x)), _mm_setzero_si128()));
+            x += 16;
+        }
+        if (x + 8 <= width) {
+            acc128 = _mm_add_epi64(acc128, _mm_sad_epu8(_mm_loadl_epi64((const __m128i*)(data + x)), _mm_setzero_si128()));
+            x += 8;
+        }
+        for (; x < width; x++)
+            tail += data[x];
+    }
+
+    return _sum256(acc) + _sum64(acc128) + tail;
+}
+
+// _sumBlockPlanes of KernelsSSE2.c 32 bytes at a time
+static void _sumBlockPlanes(const uint8_t* const planes[3], size_t stride, int width, int height, uint64_t sums[3]) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i tail = _mm256_loadu_si256((const __m256i*)(kernels_prefix_masks + 32 - (width & 31)));
+    __m256i acc[3] = { zero, zero, zero };
+
+    for (int y = 0; y < height; y++) {
+        size_t row = (size_t)y * stride;
+        for (int c = 0; c < 3; c++) {
+            const uint8_t* p = planes[c] + row;
+            int x = 0;
+            for (; x + 32 <= width; x += 32)
+                acc[c] = _mm256_add_epi64(acc[c], _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(p + x)), zero));
+            if (x < width)
+                acc[c] = _mm256_add_epi64(acc[c], _mm256_sad_epu8(_mm256_and_si256(_mm256_loadu_si256((const __m256i*)(p + x)), tail), zero));
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+        sums[c] = _sum256(acc[c]);
+}
+
+// Adds the channel sums of `bytes` bytes of whole pixels (a multiple of 32)
+KERNELS_INLINE void _sumChannels(const uint8_t* p, const uint8_t (*masks)[KERNELS_MASK_BYTES], int bytes, __m256i acc[3]) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int k = 0; k < bytes; k += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + k));
+        for (int c = 0; c < 3; c++) {
+            __m256i mask = _mm256_loadu_si256((const __m256i*)(masks[c] + k));
+            acc[c] = _mm256_add_epi64(acc[c], _mm256_sad_epu8(_mm256_and_si256(v, mask), zero));
+        }
+    }
+}
+
+// Same for 48 bytes of 3-channel pixels
+KERNELS_INLINE void _sumChannels48(const uint8_t* p, const uint8_t (*masks)[KERNELS_MASK_BYTES], __m128i acc[3]) {
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int k = 0; k < 48; k += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + k));
+        for (int c = 0; c < 3; c++) {
+            __m128i mask = _mm_loadu_si128((const __m128i*)(masks[c] + k));
+            acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(_mm_and_si128(v, mask), zero));
+        }
+    }
+}
+
+static void _sumBlockRGB(const uint8_t* data, size_t stride, int width, int height, int channels, uint64_t sums[3]) {
+    if (channels != 3 && channels != 4) {
+        Kernels_sumBlockRGBScalar(data, stride, width, height, channels, sums);
+        return;
+    }
+
+    const uint8_t (*masks)[KERNELS_MASK_BYTES] = kernels_channel_masks[channels - 3];
+
+    __m256i acc[3] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+    __m128i acc128[3] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+    uint64_t tail[3] = { 0, 0, 0 };
+
+    for (int y = 0; y < height; y++, data += stride) {
+        int x = 0;
+        if (channels == 3) {
+            // the channel pattern repeats every 96 bytes, 32 pixels
+            for (; x + 32 <= width; x += 32)
+                _sumChannels(data + 3 * x, masks, 96, acc);
+            if (x + 16 <= width) {
+                _sumChannels48(data + 3 * x, masks, acc128);
+                x += 16;
+            }
+        } else {
+            for (; x + 8 <= width; x += 8)
+                _sumChannels(data + 4 * x, masks, 32, acc);
+        }
+
+        for (const uint8_t* p = data + x * channels; x < width; x++, p += channels) {
+            tail[0] += p[0];
+            tail[1] += p[1];
+            tail[2] += p[2];
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+        sums[c] = _sum256(acc[c]) + _sum64(acc128[c]) + tail[c];
+}
+
+// 16 bytes widened to 16-bit lanes
+static int32_t _dotRow(const uint8_t* data, const int16_t* weights, int count) {
+    __m256i acc = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(data + x)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(v, _mm256_loadu_si256((const __m256i*)(weights + x))));
+    }
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    if (x + 8 <= count) {
+        __m128i v = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(data + x)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_loadu_si128((const __m128i*)(weights + x))));
+        x += 8;
+    }
+
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    return _mm_cvtsi128_si32(sum) + Kernels_dotRowScalar(data + x, weights + x, count - x);
+}
+
+static inline __m256i _load16(const uint8_t* p) {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p));
+}
+
+static float _sobelRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, int width) {
+    const __m256 limit = _mm256_set1_ps(255.0f);
+    __m256 max_vec = _mm256_setzero_ps();
+
+    // columns 1 .. width - 2, 16 pixels at a time
+    int x = 1;
+    for (; x + 16 < width; x += 16) {
+        __m256i al = _load16(above + x - 1), ax = _load16(above + x), ar = _load16(above + x + 1);
+        __m256i ml = _load16(row + x - 1),                            mr = _load16(row + x + 1);
+        __m256i bl = _load16(below + x - 1), bx = _load16(below + x), br = _load16(below + x + 1);
+
+        __m256i gx = _mm256_sub_epi16(_mm256_add_epi16(ar, br), _mm256_add_epi16(al, bl));
+        gx = _mm256_sub_epi16(gx, _mm256_slli_epi16(_mm256_add_epi16(ml, mr), 1));
+        __m256i gy = _mm256_add_epi16(_mm256_add_epi16(bl, br), _mm256_slli_epi16(bx, 1));
+        gy = _mm256_sub_epi16(gy, _mm256_add_epi16(_mm256_add_epi16(al, ar), _mm256_slli_epi16(ax, 1)));
+
+        // the in-lane unpacks are undone by the in-lane pack below
+        __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+        __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+        __m256 mag_lo = _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(lo, lo)));
+        __m256 mag_hi = _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(hi, hi)));
+        max_vec = _mm256_max_ps(max_vec, _mm256_max_ps(mag_lo, mag_hi));
+
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(_mm256_min_ps(mag_lo, limit)),
+                                            _mm256_cvttps_epi32(_mm256_min_ps(mag_hi, limit)));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+        _mm_storeu_si128((__m128i*)(out + x), bytes);
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, max_vec);
+    float max_val = 0.0f;
+    for (int i = 0; i < 8; i++)
+        max_val = fmaxf(max_val, lanes[i]);
+
+    max_val = fmaxf(max_val, Kernels_sobelSpan(above, row, below, out, 0, width < 1 ? width : 1, width));
+    return fmaxf(max_val, Kernels_sobelSpan(above, row, below, out, x, width, width));
+}
+
+static void _quantize16(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i r32 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(r + i)));
+        __m256i g32 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(g + i)));
+        __m256i b32 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(b + i)));
+
+        __m256i best = _mm256_set1_epi32(INT_MAX);
+        __m256i index = _mm256_setzero_si256();
+
+        for (int p = 0; p < 16; p++) {
+            __m256i dr = _mm256_sub_epi32(r32, _mm256_set1_epi32(KERNELS_ANSI16_RGB[p][0]));
+            __m256i dg = _mm256_sub_epi32(g32, _mm256_set1_epi32(KERNELS_ANSI16_RGB[p][1]));
+            __m256i db = _mm256_sub_epi32(b32, _mm256_set1_epi32(KERNELS_ANSI16_RGB[p][2]));
+
+            __m256i dist = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(dr, dr), _mm256_mullo_epi32(dg, dg)),
+                                            _mm256_mullo_epi32(db, db));
+
+            // strictly closer only, so ties keep the lower index
+            __m256i closer = _mm256_cmpgt_epi32(best, dist);
+            best = _mm256_min_epi32(best, dist);
+            index = _mm256_blendv_epi8(index, _mm256_set1_epi32(p), closer);
+        }
+
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(index), _mm256_extracti128_si256(index, 1));
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(packed, packed));
+    }
+
+    Kernels_quantize16Scalar(r + i, g + i, b + i, out + i, count - i);
+}
+
+// 16 + 36 * r6 + 6 * g6 + b6 of 16 cells held as 16-bit lanes
+static inline __m256i _cubeIndex(__m256i r16, __m256i g16, __m256i b16) {
+    const __m256i six = _mm256_set1_epi16(6);
+
+    __m256i r6 = _mm256_srli_epi16(_mm256_mullo_epi16(r16, six), 8);
+    __m256i g6 = _mm256_srli_epi16(_mm256_mullo_epi16(g16, six), 8);
+    __m256i b6 = _mm256_srli_epi16(_mm256_mullo_epi16(b16, six), 8);
+
+    __m256i index = _mm256_add_epi16(_mm256_mullo_epi16(r6, _mm256_set1_epi16(36)), _mm256_mullo_epi16(g6, six));
+    return _mm256_add_epi16(_mm256_add_epi16(index, b6), _mm256_set1_epi16(16));
+}
+
+static void _quantize256(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i index = _cubeIndex(_load16(r + i), _load16(g + i), _load16(b + i));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(index), _mm256_extracti128_si256(index, 1));
+        _mm_storeu_si128((__m128i*)(out + i), bytes);
+    }
+
+    Kernels_quantize256Scalar(r + i, g + i, b + i, out + i, count - i);
+}
+
+void Kernels_bindAVX2(Kernels* kernels) {
+    kernels->grayscale = _grayscale;
+    kernels->grayscalePlanar = _grayscalePlanar;
+    kernels->sumBlock = _sumBlock;
+    kernels->sumBlockRGB = _sumBlockRGB;
+    kernels->sumBlockPlanes = _sumBlockPlanes;
+    kernels->dotRow = _dotRow;
+    kernels->sobelRow = _sobelRow;
+    kernels->quantize16 = _quantize16;
+    kernels->quantize256 = _quantize256;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#else
+#pragma GCC target("avx512f,avx512bw")
+#endif
+
+#include "KernelsX86.h"
+
+// Luminance of 8 pixels in the float and double steps of Kernels_grayscaleScalar
+KERNELS_INLINE __m256i _luminance8(__m128i r, __m128i g, __m128i b) {
+    __m256 red = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(r)), _mm256_set1_ps(KERNELS_LUMA_R));
+
+    __m512d sum = _mm512_add_pd(_mm512_cvtps_pd(red),
+                                _mm512_mul_pd(_mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(g)), _mm512_set1_pd(KERNELS_LUMA_G)));
+    sum = _mm512_add_pd(sum, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(b)), _mm512_set1_pd(KERNELS_LUMA_B)));
+
+    return _mm512_cvttpd_epi32(sum);
+}
+
+KERNELS_INLINE __m128i _luminance16(__m128i r, __m128i g, __m128i b) {
+    __m256i lo = _luminance8(r, g, b);
+    __m256i hi = _luminance8(_mm_srli_si128(r, 8), _mm_srli_si128(g, 8), _mm_srli_si128(b, 8));
+
+    return _mm512_cvtepi32_epi8(_mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1));
+}
+
+KERNELS_INLINE __m128i _gray16(const __m128i planes[4], int channels, KernelGray mode) {
+    __m128i gray = (mode == KERNEL_GRAY_AVERAGE)         ? _average16(planes[0], planes[1], planes[2])
+                 : (mode == KERNEL_GRAY_LUMINANCE_FIXED) ? _lumaFixed16(planes[0], planes[1], planes[2])
+                                                         : _luminance16(planes[0], planes[1], planes[2]);
+    return (channels == 4) ? _applyAlpha(gray, planes[3]) : gray;
+}
+
+KERNELS_INLINE void _grayscale16(const uint8_t* src, int channels, uint8_t* dst, KernelGray mode) {
+    __m128i planes[4];
+    _deinterleave16(src, channels, planes);
+    _mm_storeu_si128((__m128i*)dst, _gray16(planes, channels, mode));
+}
+
+static void _grayscale(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels == 3) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 3 * i, 3, dst + i, mode);
+    } else if (channels == 4) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 4 * i, 4, dst + i, mode);
+    }
+
+    Kernels_grayscaleScalar(src + i * channels, channels, dst + i, count - i, mode);
+}
+
+static void _grayscalePlanar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels >= 3) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            _loadPlanes16(planes, channels, i, v);
+            _mm_storeu_si128((__m128i*)(dst + i), _gray16(v, channels, mode));
+        }
+    }
+
+    _grayscalePlanarTail(planes, channels, dst, count, i, mode);
+}
+
+static uint64_t _sumBlock(const uint8_t* data, size_t stride, int width, int height) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i acc = zero;
+
+    // a masked load picks up the end of each row without a scalar tail
+    int whole = width & ~63;
+    __mmask64 rest = (width & 63) ? (~0ULL >> (64 - (width & 63))) : 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        for (int x = 0; x < whole; x += 64)
+            acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_loadu_si512((const void*)(data + x)), zero));
+        if (rest)
+            acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_maskz_loadu_epi8(rest, data + whole), zero));
+    }
+
+    return (uint64_t)_mm512_reduce_add_epi64(acc);
+}
+
+static void _quantize256(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    const __m512i six = _mm512_set1_epi16(6);
+    size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m512i r6 = _mm512_srli_epi16(_mm512_mullo_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(r + i))), six), 8);
+        __m512i g6 = _mm512_srli_epi16(_mm512_mullo_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(g + i))), six), 8);
+        __m512i b6 = _mm512_srli_epi16(_mm512_mullo_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(b + i))), six), 8);
+
+        __m512i index = _mm512_add_epi16(_mm512_mullo_epi16(r6, _mm512_set1_epi16(36)), _mm512_mullo_epi16(g6, six));
+        index = _mm512_add_epi16(_mm512_add_epi16(index, b6), _mm512_set1_epi16(16));
+
+        _mm256_storeu_si256((__m256i*)(out + i), _mm512_cvtepi16_epi8(index));
+    }
+
+    Kernels_quantize256Scalar(r + i, g + i, b + i, out + i, count - i);
+}
+
+// The RGB sums, Sobel rows and 16-color search keep their AVX2 versions
+void Kernels_bindAVX512(Kernels* kernels) {
+    kernels->grayscale = _grayscale;
+    kernels->grayscalePlanar = _grayscalePlanar;
+    kernels->sumBlock = _sumBlock;
+    kernels->quantize256 = _quantize256;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
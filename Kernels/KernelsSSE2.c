@@ -0,0 +1,275 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC target("sse2")
+#endif
+
+#include "KernelsX86.h"
+
+uint8_t kernels_channel_masks[2][3][KERNELS_MASK_BYTES];
+
+// The float luminance is left to the scalar code, it needs the SSE4.1 conversions
+static void _grayscalePlanar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels >= 3 && mode != KERNEL_GRAY_LUMINANCE) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            _loadPlanes16(planes, channels, i, v);
+
+            __m128i gray = (mode == KERNEL_GRAY_AVERAGE) ? _average16(v[0], v[1], v[2]) : _lumaFixed16(v[0], v[1], v[2]);
+            if (channels == 4) gray = _applyAlpha(gray, v[3]);
+
+            _mm_storeu_si128((__m128i*)(dst + i), gray);
+        }
+    }
+
+    _grayscalePlanarTail(planes, channels, dst, count, i, mode);
+}
+
+static uint64_t _sumBlock(const uint8_t* data, size_t stride, int width, int height) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    uint64_t tail = 0;
+
+    for (int y = 0; y < height; y++, data += stride) {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(data + x)), zero));
+        if (x + 8 <= width) {
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadl_epi64((const __m128i*)(data + x)), zero));
+            x += 8;
+        }
+        for (; x < width; x++)
+            tail += data[x];
+    }
+
+    return _sum64(acc) + tail;
+}
+
+// The rows of each plane end in one masked load instead of a scalar tail
+static void _sumBlockPlanes(const uint8_t* const planes[3], size_t stride, int width, int height, uint64_t sums[3]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tail = _mm_loadu_si128((const __m128i*)(kernels_prefix_masks + 32 - (width & 15)));
+    __m128i acc[3] = { zero, zero, zero };
+
+    for (int y = 0; y < height; y++) {
+        size_t row = (size_t)y * stride;
+        for (int c = 0; c < 3; c++) {
+            const uint8_t* p = planes[c] + row;
+            int x = 0;
+            for (; x + 16 <= width; x += 16)
+                acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(p + x)), zero));
+            if (x < width)
+                acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(_mm_and_si128(_mm_loadu_si128((const __m128i*)(p + x)), tail), zero));
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+        sums[c] = _sum64(acc[c]);
+}
+
+// Adds the channel sums of `bytes` bytes of whole pixels (a multiple of 16)
+KERNELS_INLINE void _sumChannels(const uint8_t* p, const uint8_t (*masks)[KERNELS_MASK_BYTES], int bytes, __m128i acc[3]) {
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int k = 0; k < bytes; k += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + k));
+        for (int c = 0; c < 3; c++) {
+            __m128i mask = _mm_loadu_si128((const __m128i*)(masks[c] + k));
+            acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(_mm_and_si128(v, mask), zero));
+        }
+    }
+}
+
+static void _sumBlockRGB(const uint8_t* data, size_t stride, int width, int height, int channels, uint64_t sums[3]) {
+    if (channels != 3 && channels != 4) {
+        Kernels_sumBlockRGBScalar(data, stride, width, height, channels, sums);
+        return;
+    }
+
+    const uint8_t (*masks)[KERNELS_MASK_BYTES] = kernels_channel_masks[channels - 3];
+    // 16 pixels of 3 channels or 4 of 4 channels fill whole vectors
+    int step = (channels == 3) ? 16 : 4;
+
+    __m128i acc[3] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+    uint64_t tail[3] = { 0, 0, 0 };
+
+    for (int y = 0; y < height; y++, data += stride) {
+        int x = 0;
+        for (; x + step <= width; x += step) {
+            if (channels == 3) _sumChannels(data + 3 * x, masks, 48, acc);
+            else               _sumChannels(data + 4 * x, masks, 16, acc);
+        }
+        for (const uint8_t* p = data + x * channels; x < width; x++, p += channels) {
+            tail[0] += p[0];
+            tail[1] += p[1];
+            tail[2] += p[2];
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+        sums[c] = _sum64(acc[c]) + tail[c];
+}
+
+// 8 bytes widened to 16-bit lanes
+// 8 bytes widened to 16 bits times 8 weights, added pairwise into 4 lanes
+static inline __m128i _dot8(__m128i bytes, const int16_t* weights) {
+    return _mm_madd_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_loadu_si128((const __m128i*)weights));
+}
+
+static int32_t _dotRow(const uint8_t* data, const int16_t* weights, int count) {
+    __m128i acc = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + x));
+        acc = _mm_add_epi32(acc, _dot8(v, weights + x));
+        acc = _mm_add_epi32(acc, _dot8(_mm_srli_si128(v, 8), weights + x + 8));
+    }
+    if (x + 8 <= count) {
+        acc = _mm_add_epi32(acc, _dot8(_mm_loadl_epi64((const __m128i*)(data + x)), weights + x));
+        x += 8;
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc) + Kernels_dotRowScalar(data + x, weights + x, count - x);
+}
+
+static inline __m128i _load8(const uint8_t* p) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+}
+
+static float _sobelRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, int width) {
+    const __m128 limit = _mm_set1_ps(255.0f);
+    __m128 max_vec = _mm_setzero_ps();
+
+    // the border columns clamp their neighbours and go through the scalar
+    // path, everything between them 8 pixels at a time
+    int x = 1;
+    for (; x + 8 < width; x += 8) {
+        __m128i al = _load8(above + x - 1), ax = _load8(above + x), ar = _load8(above + x + 1);
+        __m128i ml = _load8(row + x - 1),                           mr = _load8(row + x + 1);
+        __m128i bl = _load8(below + x - 1), bx = _load8(below + x), br = _load8(below + x + 1);
+
+        __m128i gx = _mm_sub_epi16(_mm_add_epi16(ar, br), _mm_add_epi16(al, bl));
+        gx = _mm_sub_epi16(gx, _mm_slli_epi16(_mm_add_epi16(ml, mr), 1));
+        __m128i gy = _mm_add_epi16(_mm_add_epi16(bl, br), _mm_slli_epi16(bx, 1));
+        gy = _mm_sub_epi16(gy, _mm_add_epi16(_mm_add_epi16(al, ar), _mm_slli_epi16(ax, 1)));
+
+        // gx*gx + gy*gy per 32-bit lane
+        __m128i lo = _mm_unpacklo_epi16(gx, gy);
+        __m128i hi = _mm_unpackhi_epi16(gx, gy);
+        __m128 mag_lo = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo)));
+        __m128 mag_hi = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi)));
+        max_vec = _mm_max_ps(max_vec, _mm_max_ps(mag_lo, mag_hi));
+
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(_mm_min_ps(mag_lo, limit)),
+                                         _mm_cvttps_epi32(_mm_min_ps(mag_hi, limit)));
+        _mm_storel_epi64((__m128i*)(out + x), _mm_packus_epi16(packed, packed));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, max_vec);
+    float max_val = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+
+    max_val = fmaxf(max_val, Kernels_sobelSpan(above, row, below, out, 0, width < 1 ? width : 1, width));
+    return fmaxf(max_val, Kernels_sobelSpan(above, row, below, out, x, width, width));
+}
+
+static void _quantize16(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i r16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(r + i)), zero);
+        __m128i g16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(g + i)), zero);
+        __m128i b16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b + i)), zero);
+
+        __m128i best_lo = _mm_set1_epi32(INT_MAX), best_hi = best_lo;
+        __m128i index_lo = zero, index_hi = zero;
+
+        for (int p = 0; p < 16; p++) {
+            __m128i dr = _mm_sub_epi16(r16, _mm_set1_epi16(KERNELS_ANSI16_RGB[p][0]));
+            __m128i dg = _mm_sub_epi16(g16, _mm_set1_epi16(KERNELS_ANSI16_RGB[p][1]));
+            __m128i db = _mm_sub_epi16(b16, _mm_set1_epi16(KERNELS_ANSI16_RGB[p][2]));
+
+            // dr*dr + dg*dg + db*db of four cells per 32-bit lane
+            __m128i rg_lo = _mm_unpacklo_epi16(dr, dg), rg_hi = _mm_unpackhi_epi16(dr, dg);
+            __m128i b_lo = _mm_unpacklo_epi16(db, zero), b_hi = _mm_unpackhi_epi16(db, zero);
+            __m128i dist_lo = _mm_add_epi32(_mm_madd_epi16(rg_lo, rg_lo), _mm_madd_epi16(b_lo, b_lo));
+            __m128i dist_hi = _mm_add_epi32(_mm_madd_epi16(rg_hi, rg_hi), _mm_madd_epi16(b_hi, b_hi));
+
+            // strictly closer only, so ties keep the lower index
+            __m128i closer_lo = _mm_cmplt_epi32(dist_lo, best_lo);
+            __m128i closer_hi = _mm_cmplt_epi32(dist_hi, best_hi);
+            __m128i entry = _mm_set1_epi32(p);
+
+            best_lo = _mm_or_si128(_mm_and_si128(closer_lo, dist_lo), _mm_andnot_si128(closer_lo, best_lo));
+            best_hi = _mm_or_si128(_mm_and_si128(closer_hi, dist_hi), _mm_andnot_si128(closer_hi, best_hi));
+            index_lo = _mm_or_si128(_mm_and_si128(closer_lo, entry), _mm_andnot_si128(closer_lo, index_lo));
+            index_hi = _mm_or_si128(_mm_and_si128(closer_hi, entry), _mm_andnot_si128(closer_hi, index_hi));
+        }
+
+        __m128i index = _mm_packs_epi32(index_lo, index_hi);
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(index, index));
+    }
+
+    Kernels_quantize16Scalar(r + i, g + i, b + i, out + i, count - i);
+}
+
+// 16 + 36 * r6 + 6 * g6 + b6 of 8 cells held as 16-bit lanes
+static inline __m128i _cubeIndex(__m128i r16, __m128i g16, __m128i b16) {
+    const __m128i six = _mm_set1_epi16(6);
+
+    __m128i r6 = _mm_srli_epi16(_mm_mullo_epi16(r16, six), 8);
+    __m128i g6 = _mm_srli_epi16(_mm_mullo_epi16(g16, six), 8);
+    __m128i b6 = _mm_srli_epi16(_mm_mullo_epi16(b16, six), 8);
+
+    __m128i index = _mm_add_epi16(_mm_mullo_epi16(r6, _mm_set1_epi16(36)), _mm_mullo_epi16(g6, six));
+    return _mm_add_epi16(_mm_add_epi16(index, b6), _mm_set1_epi16(16));
+}
+
+static void _quantize256(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* out, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i rv = _mm_loadu_si128((const __m128i*)(r + i));
+        __m128i gv = _mm_loadu_si128((const __m128i*)(g + i));
+        __m128i bv = _mm_loadu_si128((const __m128i*)(b + i));
+
+        __m128i lo = _cubeIndex(_mm_unpacklo_epi8(rv, zero), _mm_unpacklo_epi8(gv, zero), _mm_unpacklo_epi8(bv, zero));
+        __m128i hi = _cubeIndex(_mm_unpackhi_epi8(rv, zero), _mm_unpackhi_epi8(gv, zero), _mm_unpackhi_epi8(bv, zero));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+
+    Kernels_quantize256Scalar(r + i, g + i, b + i, out + i, count - i);
+}
+
+void Kernels_bindSSE2(Kernels* kernels) {
+    for (int layout = 0; layout < 2; layout++) {
+        int channels = layout + 3;
+        for (int c = 0; c < 3; c++)
+            for (int j = 0; j < KERNELS_MASK_BYTES; j++)
+                kernels_channel_masks[layout][c][j] = (j % channels == c) ? 0xFF : 0;
+    }
+
+    kernels->grayscalePlanar = _grayscalePlanar;
+    kernels->sumBlock = _sumBlock;
+    kernels->sumBlockRGB = _sumBlockRGB;
+    kernels->sumBlockPlanes = _sumBlockPlanes;
+    kernels->dotRow = _dotRow;
+    kernels->sobelRow = _sobelRow;
+    kernels->quantize16 = _quantize16;
+    kernels->quantize256 = _quantize256;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
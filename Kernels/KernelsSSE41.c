@@ -0,0 +1,125 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#else
+#pragma GCC target("sse4.1")
+#endif
+
+#include "KernelsX86.h"
+
+int8_t kernels_deinterleave_masks[2][4][4][16];
+
+// Luminance of 4 pixels, evaluated in the same float and double steps as
+// Kernels_grayscaleScalar so every value truncates the same way
+KERNELS_INLINE __m128i _luminance4(__m128i r, __m128i g, __m128i b) {
+    const __m128d weight_g = _mm_set1_pd(KERNELS_LUMA_G);
+    const __m128d weight_b = _mm_set1_pd(KERNELS_LUMA_B);
+
+    __m128 red = _mm_mul_ps(_mm_cvtepi32_ps(r), _mm_set1_ps(KERNELS_LUMA_R));
+
+    __m128d lo = _mm_add_pd(_mm_cvtps_pd(red), _mm_mul_pd(_mm_cvtepi32_pd(g), weight_g));
+    lo = _mm_add_pd(lo, _mm_mul_pd(_mm_cvtepi32_pd(b), weight_b));
+
+    __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(red, red)), _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(g, 8)), weight_g));
+    hi = _mm_add_pd(hi, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(b, 8)), weight_b));
+
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+KERNELS_INLINE __m128i _luminance16(__m128i r, __m128i g, __m128i b) {
+    __m128i quarters[4];
+    for (int k = 0; k < 4; k++) {
+        quarters[k] = _luminance4(_mm_cvtepu8_epi32(r), _mm_cvtepu8_epi32(g), _mm_cvtepu8_epi32(b));
+        r = _mm_srli_si128(r, 4);
+        g = _mm_srli_si128(g, 4);
+        b = _mm_srli_si128(b, 4);
+    }
+
+    return _mm_packus_epi16(_mm_packs_epi32(quarters[0], quarters[1]), _mm_packs_epi32(quarters[2], quarters[3]));
+}
+
+KERNELS_INLINE __m128i _gray16(const __m128i planes[4], int channels, KernelGray mode) {
+    __m128i gray = (mode == KERNEL_GRAY_AVERAGE)         ? _average16(planes[0], planes[1], planes[2])
+                 : (mode == KERNEL_GRAY_LUMINANCE_FIXED) ? _lumaFixed16(planes[0], planes[1], planes[2])
+                                                         : _luminance16(planes[0], planes[1], planes[2]);
+    return (channels == 4) ? _applyAlpha(gray, planes[3]) : gray;
+}
+
+KERNELS_INLINE void _grayscale16(const uint8_t* src, int channels, uint8_t* dst, KernelGray mode) {
+    __m128i planes[4];
+    _deinterleave16(src, channels, planes);
+    _mm_storeu_si128((__m128i*)dst, _gray16(planes, channels, mode));
+}
+
+static void _grayscale(const uint8_t* src, int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    // separate loops give each layout constant shuffles
+    if (channels == 3) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 3 * i, 3, dst + i, mode);
+    } else if (channels == 4) {
+        for (; i + 16 <= count; i += 16)
+            _grayscale16(src + 4 * i, 4, dst + i, mode);
+    }
+
+    Kernels_grayscaleScalar(src + i * channels, channels, dst + i, count - i, mode);
+}
+
+static void _grayscalePlanar(const uint8_t* const planes[4], int channels, uint8_t* dst, size_t count, KernelGray mode) {
+    size_t i = 0;
+
+    if (channels >= 3) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            _loadPlanes16(planes, channels, i, v);
+            _mm_storeu_si128((__m128i*)(dst + i), _gray16(v, channels, mode));
+        }
+    }
+
+    _grayscalePlanarTail(planes, channels, dst, count, i, mode);
+}
+
+static void _deinterleave(const uint8_t* src, int channels, uint8_t* const planes[4], size_t count) {
+    size_t i = 0;
+
+    if (channels == 3 || channels == 4) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            _deinterleave16(src + channels * i, channels, v);
+            for (int c = 0; c < channels; c++)
+                _mm_storeu_si128((__m128i*)(planes[c] + i), v[c]);
+        }
+    }
+
+    uint8_t* rest[4] = { NULL, NULL, NULL, NULL };
+    for (int c = 0; c < channels; c++)
+        rest[c] = planes[c] + i;
+    Kernels_deinterleaveScalar(src + channels * i, channels, rest, count - i);
+}
+
+void Kernels_bindSSE41(Kernels* kernels) {
+    for (int layout = 0; layout < 2; layout++) {
+        int channels = layout + 3;
+        for (int c = 0; c < channels; c++) {
+            for (int k = 0; k < channels; k++) {
+                // byte i of the plane is byte channels * i + c of the pixels
+                for (int i = 0; i < 16; i++) {
+                    int source = channels * i + c;
+                    kernels_deinterleave_masks[layout][c][k][i] = (source / 16 == k) ? source % 16 : -1;
+                }
+            }
+        }
+    }
+
+    kernels->grayscale = _grayscale;
+    kernels->grayscalePlanar = _grayscalePlanar;
+    kernels->deinterleave = _deinterleave;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef KERNELS_X86_H
+#define KERNELS_X86_H
+
+// Helpers shared by the x86 kernel files. Each of those files sets its
+// instruction set with a target pragma before including this header, so the
+// helpers are compiled for the level of their caller; only the ones a level
+// can run are ever called from it.
+
+#include <immintrin.h>
+
+#include "Kernels.h"
+
+// Helpers whose arguments must fold into constants at each call site
+#define KERNELS_INLINE static inline __attribute__((always_inline))
+
+// Period of the channel layout of 3 and 4 channel pixels in the vector loops
+#define KERNELS_MASK_BYTES 96
+
+// kernels_channel_masks[channels - 3][c] has 0xFF on the bytes of channel c
+// (filled by Kernels_bindSSE2)
+extern uint8_t kernels_channel_masks[2][3][KERNELS_MASK_BYTES];
+
+// kernels_deinterleave_masks[channels - 3][c][k] gathers the bytes of channel
+// c found in the k-th 16 bytes of 16 pixels (filled by Kernels_bindSSE41)
+extern int8_t kernels_deinterleave_masks[2][4][4][16];
+
+// 32 bytes of 0xFF then 32 zeros: the 16 or 32 bytes at 32 - n keep the first n bytes of a load
+static const uint8_t kernels_prefix_masks[64] = { [0 ... 31] = 0xFF };
+
+// Adds the two 64-bit lanes of a psadbw accumulator
+static inline uint64_t _sum64(__m128i v) {
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, v);
+    return lanes[0] + lanes[1];
+}
+
+// Splits 16 pixels of 3 or 4 channels into one vector per channel; the
+// alpha vector is only written for 4 channels (SSSE3)
+KERNELS_INLINE void _deinterleave16(const uint8_t* src, int channels, __m128i planes[4]) {
+    const int8_t (*masks)[4][16] = kernels_deinterleave_masks[channels - 3];
+
+    __m128i parts[4];
+    for (int k = 0; k < channels; k++)
+        parts[k] = _mm_loadu_si128((const __m128i*)(src + 16 * k));
+
+    for (int c = 0; c < channels; c++) {
+        __m128i plane = _mm_setzero_si128();
+        for (int k = 0; k < channels; k++)
+            plane = _mm_or_si128(plane, _mm_shuffle_epi8(parts[k], _mm_loadu_si128((const __m128i*)masks[c][k])));
+        planes[c] = plane;
+    }
+}
+
+// Loads 16 pixels from each of the planes of `channels` channels
+KERNELS_INLINE void _loadPlanes16(const uint8_t* const planes[4], int channels, size_t i, __m128i out[4]) {
+    for (int c = 0; c < channels; c++)
+        out[c] = _mm_loadu_si128((const __m128i*)(planes[c] + i));
+}
+
+// Scalar grayscalePlanar from pixel `done` on, for the tails of the vector loops
+static inline void _grayscalePlanarTail(const uint8_t* const planes[4], int channels, uint8_t* dst,
+                                        size_t count, size_t done, KernelGray mode) {
+    const uint8_t* rest[4] = { NULL, NULL, NULL, NULL };
+    for (int c = 0; c < channels; c++)
+        rest[c] = planes[c] + done;
+
+    Kernels_grayscalePlanarScalar(rest, channels, dst + done, count - done, mode);
+}
+
+// floor((r + g + b) / 3) of 16 pixels; the multiply by 0xAAAB / 2^17 is
+// exact for sums up to 765
+KERNELS_INLINE __m128i _average16(__m128i r, __m128i g, __m128i b) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i third = _mm_set1_epi16((short)0xAAAB);
+
+    __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero)), _mm_unpacklo_epi8(b, zero));
+    __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero)), _mm_unpackhi_epi8(b, zero));
+
+    lo = _mm_srli_epi16(_mm_mulhi_epu16(lo, third), 1);
+    hi = _mm_srli_epi16(_mm_mulhi_epu16(hi, third), 1);
+    return _mm_packus_epi16(lo, hi);
+}
+
+// Kernels_lumaFixed of 16 pixels: (r, g) and (b, 0) pairs go through pmaddwd
+// with (R, G) and (B, 0) weights
+KERNELS_INLINE __m128i _lumaFixed16(__m128i r, __m128i g, __m128i b) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights_rg = _mm_set1_epi32((KERNELS_LUMA_FIXED_G << 16) | KERNELS_LUMA_FIXED_R);
+    const __m128i weights_b = _mm_set1_epi32(KERNELS_LUMA_FIXED_B);
+
+    __m128i halves[2];
+    for (int h = 0; h < 2; h++) {
+        __m128i r16 = h ? _mm_unpackhi_epi8(r, zero) : _mm_unpacklo_epi8(r, zero);
+        __m128i g16 = h ? _mm_unpackhi_epi8(g, zero) : _mm_unpacklo_epi8(g, zero);
+        __m128i b16 = h ? _mm_unpackhi_epi8(b, zero) : _mm_unpacklo_epi8(b, zero);
+
+        __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r16, g16), weights_rg),
+                                   _mm_madd_epi16(_mm_unpacklo_epi16(b16, zero), weights_b));
+        __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r16, g16), weights_rg),
+                                   _mm_madd_epi16(_mm_unpackhi_epi16(b16, zero), weights_b));
+
+        halves[h] = _mm_packs_epi32(_mm_srli_epi32(lo, KERNELS_LUMA_FIXED_SHIFT), _mm_srli_epi32(hi, KERNELS_LUMA_FIXED_SHIFT));
+    }
+
+    return _mm_packus_epi16(halves[0], halves[1]);
+}
+
+// Clears the gray value of pixels with alpha below 128
+KERNELS_INLINE __m128i _applyAlpha(__m128i gray, __m128i alpha) {
+    return _mm_and_si128(gray, _mm_cmplt_epi8(alpha, _mm_setzero_si128()));
+}
+
+#endif // KERNELS_X86_H
@@ -0,0 +1,158 @@
+#include "Client.h"
+
+#define CLIENT_CHUNK (64 * 1024)
+
+// Reads all of stdin into a growing buffer
+static unsigned char* _readStdin(size_t* length) {
+    size_t capacity = CLIENT_CHUNK, used = 0;
+    unsigned char* data = malloc(capacity);
+
+    while (data) {
+        if (used == capacity) {
+            unsigned char* grown = realloc(data, capacity * 2);
+            if (!grown) break;
+            data = grown;
+            capacity *= 2;
+        }
+
+        ssize_t got = read(STDIN_FILENO, data + used, capacity - used);
+        if (got == 0) {
+            *length = used;
+            return data;
+        }
+        if (got < 0 && errno != EINTR) break;
+        if (got > 0) used += (size_t)got;
+    }
+
+    fprintf(stderr, "Client: failed to read stdin.\n");
+    free(data);
+    return NULL;
+}
+
+// Pins the grid to what a local render would pick (the server has no terminal)
+static bool _resolveGrid(const unsigned char* bytes, size_t length, ASCIIGenConfig* cfg) {
+    if (cfg->columns > 0 || cfg->rows > 0)
+        return true;
+
+    Image header = { 0 };
+    if (!Image_readDimensions(bytes, length, &header.width, &header.height)) {
+        fprintf(stderr, "Client: unsupported image.\n");
+        return false;
+    }
+
+    Generator_computeGridSize(&header, cfg, &cfg->columns, &cfg->rows);
+    return true;
+}
+
+static bool _receive(int fd, const char* output_path) {
+    ResponseHeader response;
+    if (!Protocol_readFull(fd, &response, sizeof(response)) || response.magic != PROTOCOL_MAGIC) {
+        fprintf(stderr, "Client: no valid response from server.\n");
+        return false;
+    }
+
+    if (response.status != STATUS_OK) {
+        char message[256];
+        size_t length = response.length < sizeof(message) - 1 ? (size_t)response.length : sizeof(message) - 1;
+        if (!Protocol_readFull(fd, message, length)) length = 0;
+        message[length] = '\0';
+
+        fprintf(stderr, "Client: server error: %s\n", message);
+        return false;
+    }
+
+    int out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        fprintf(stderr, "Client: cannot open %s for writing.\n", output_path);
+        return false;
+    }
+
+    char buffer[CLIENT_CHUNK];
+    uint64_t remaining = response.length;
+    bool success = true;
+
+    while (success && remaining > 0) {
+        size_t chunk = remaining < sizeof(buffer) ? (size_t)remaining : sizeof(buffer);
+        success = Protocol_readFull(fd, buffer, chunk) && Protocol_writeFull(out_fd, buffer, chunk);
+        remaining -= chunk;
+    }
+
+    if (close(out_fd) != 0) success = false;
+    if (!success) fprintf(stderr, "Client: transfer of %s failed.\n", output_path);
+
+    return success;
+}
+
+bool Client_render(const char* socket_path, const char* input_path, const char* output_path,
+                   const ASCIIGenConfig* config) {
+    if (!socket_path || !input_path || !output_path) return false;
+    ASCIIGenConfig cfg = config ? *config : DEFAULT_CONFIG;
+
+    bool inline_bytes = strcmp(input_path, "-") == 0;
+    char path[PATH_MAX];
+
+    unsigned char* bytes = NULL;
+    size_t length = 0;
+    bool mapped = false;
+
+    if (inline_bytes) {
+        bytes = _readStdin(&length);
+        if (!bytes) return false;
+    } else {
+        // the server runs elsewhere in the tree, so it needs an absolute path
+        if (!realpath(input_path, path)) {
+            fprintf(stderr, "File %s does not exist\n", input_path);
+            return false;
+        }
+
+        // only the header pages are touched, to resolve the grid
+        int in_fd = open(path, O_RDONLY);
+        struct stat st;
+        if (in_fd >= 0 && fstat(in_fd, &st) == 0 && st.st_size > 0) {
+            length = (size_t)st.st_size;
+            bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, in_fd, 0);
+            mapped = bytes != MAP_FAILED;
+        }
+        if (in_fd >= 0) close(in_fd);
+        if (!mapped) {
+            fprintf(stderr, "Error reading %s\n", input_path);
+            return false;
+        }
+    }
+
+    bool success = _resolveGrid(bytes, length, &cfg);
+
+    struct sockaddr_un address;
+    int fd = -1;
+    if (success) {
+        success = Protocol_socketAddress(socket_path, &address)
+               && (fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0
+               && connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+        if (!success)
+            fprintf(stderr, "Client: cannot connect to %s.\n", socket_path);
+    }
+
+    if (success) {
+        RequestHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = PROTOCOL_MAGIC;
+        header.version = PROTOCOL_VERSION;
+        header.source = inline_bytes ? SOURCE_BYTES : SOURCE_PATH;
+        header.charset_length = (uint32_t)strlen(cfg.char_set);
+        header.payload_length = inline_bytes ? length : strlen(path);
+        Protocol_encodeConfig(&cfg, &header);
+
+        success = Protocol_writeFull(fd, &header, sizeof(header))
+               && Protocol_writeFull(fd, cfg.char_set, header.charset_length)
+               && Protocol_writeFull(fd, inline_bytes ? (const void*)bytes : (const void*)path, header.payload_length)
+               && _receive(fd, output_path);
+    }
+
+    if (fd >= 0) close(fd);
+    if (mapped)
+        munmap(bytes, length);
+    else
+        free(bytes);
+
+    return success;
+}
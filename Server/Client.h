@@ -0,0 +1,28 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "Protocol.h"
+#include "../Generator/Generator.h"
+
+// Renders through the server listening on `socket_path` and writes the result
+// to `output_path`. `input_path` is sent as an absolute path, or as inline
+// bytes when it is "-" (stdin). The grid is resolved here, so terminal-fit
+// output matches a local render.
+bool Client_render(const char* socket_path, const char* input_path, const char* output_path,
+                   const ASCIIGenConfig* config);
+
+#endif // CLIENT_H
@@ -0,0 +1,112 @@
+#include "Protocol.h"
+
+bool Protocol_readFull(int fd, void* bytes, size_t length) {
+    unsigned char* p = bytes;
+    while (length > 0) {
+        ssize_t got = read(fd, p, length);
+        if (got == 0) return false;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+bool Protocol_writeFull(int fd, const void* bytes, size_t length) {
+    const unsigned char* p = bytes;
+    while (length > 0) {
+        // MSG_NOSIGNAL: a client that went away must not kill the server
+        ssize_t put = send(fd, p, length, MSG_NOSIGNAL);
+        if (put < 0 && errno == ENOTSOCK)
+            put = write(fd, p, length);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += put;
+        length -= (size_t)put;
+    }
+    return true;
+}
+
+void Protocol_encodeConfig(const ASCIIGenConfig* config, RequestHeader* header) {
+    header->terminal_aspect_ratio = config->terminal_aspect_ratio;
+    header->use_average_pooling = config->use_average_pooling;
+    header->grayscale_method = config->grayscale_method;
+    header->color_mode = config->color_mode;
+    header->dither_mode = config->dither_mode;
+    header->edge_mode = config->edge_mode;
+    header->glyph_mode = config->glyph_mode;
+    header->output_format = config->output_format;
+    header->columns = config->columns;
+    header->rows = config->rows;
+    header->fixed_point = config->fixed_point;
+    header->linear_light = config->linear_light;
+    header->sampling = config->sampling;
+    header->crop_x = config->crop.x;
+    header->crop_y = config->crop.y;
+    header->crop_width = config->crop.width;
+    header->crop_height = config->crop.height;
+}
+
+bool Protocol_decodeConfig(const RequestHeader* header, const char* char_set, ASCIIGenConfig* config) {
+    if (header->grayscale_method > GRAY_LUMINANCE ||
+        header->color_mode > COLOR_TRUE ||
+        header->dither_mode > DITHER_FLOYD_STEINBERG ||
+        header->edge_mode > EDGE_SOBEL ||
+        header->glyph_mode > GLYPH_SHAPE ||
+        header->output_format > FORMAT_PNG ||
+        header->sampling > SAMPLING_LANCZOS ||
+        header->columns < 0 || header->rows < 0 ||
+        header->crop_x < 0 || header->crop_y < 0 || header->crop_width < 0 || header->crop_height < 0 ||
+        (header->crop_width == 0) != (header->crop_height == 0) ||
+        !(header->terminal_aspect_ratio > 0.0f) ||
+        char_set[0] == '\0')
+        return false;
+
+    *config = DEFAULT_CONFIG;
+    config->char_set = char_set;
+    config->terminal_aspect_ratio = header->terminal_aspect_ratio;
+    config->use_average_pooling = header->use_average_pooling != 0;
+    config->grayscale_method = (GrayscaleMethod)header->grayscale_method;
+    config->color_mode = (ColorMode)header->color_mode;
+    config->dither_mode = (DitherMode)header->dither_mode;
+    config->edge_mode = (EdgeMode)header->edge_mode;
+    config->glyph_mode = (GlyphMode)header->glyph_mode;
+    config->output_format = (OutputFormat)header->output_format;
+    config->columns = header->columns;
+    config->rows = header->rows;
+    config->fixed_point = header->fixed_point != 0;
+    config->linear_light = header->linear_light != 0;
+    config->sampling = (SamplingMode)header->sampling;
+    config->crop = (ImageRect){ header->crop_x, header->crop_y, header->crop_width, header->crop_height };
+
+    return true;
+}
+
+bool Protocol_sendResponse(int fd, ResponseStatus status, const void* body, size_t length) {
+    ResponseHeader header = {
+        .magic = PROTOCOL_MAGIC,
+        .status = status,
+        .length = length,
+    };
+
+    return Protocol_writeFull(fd, &header, sizeof(header))
+        && (length == 0 || Protocol_writeFull(fd, body, length));
+}
+
+bool Protocol_socketAddress(const char* path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Protocol: socket path %s is too long.\n", path);
+        return false;
+    }
+
+    strcpy(address->sun_path, path);
+    return true;
+}
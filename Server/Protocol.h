@@ -0,0 +1,84 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../Generator/Generator.h"
+
+#define PROTOCOL_MAGIC        0x52435347u    // "GSCR"
+#define PROTOCOL_VERSION      5
+
+// Requests above these sizes are refused before anything is allocated
+#define PROTOCOL_MAX_CHARSET  4096
+#define PROTOCOL_MAX_PAYLOAD  (256ull * 1024 * 1024)
+
+// One request per connection, in host byte order (the socket is local):
+//   RequestHeader, charset bytes, payload (a path or the encoded image)
+// answered by:
+//   ResponseHeader, `length` bytes of output (or of error text)
+typedef enum RequestSource {
+    SOURCE_PATH,        // payload is a path the server opens itself
+    SOURCE_BYTES        // payload is the encoded image
+} RequestSource;
+
+typedef struct RequestHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t source;
+    uint32_t charset_length;
+    uint64_t payload_length;
+    float terminal_aspect_ratio;
+    uint32_t use_average_pooling;
+    uint32_t grayscale_method;
+    uint32_t color_mode;
+    uint32_t dither_mode;
+    uint32_t edge_mode;
+    uint32_t glyph_mode;
+    uint32_t output_format;
+    int32_t columns;
+    int32_t rows;
+    uint32_t fixed_point;
+    uint32_t linear_light;
+    uint32_t sampling;
+    int32_t crop_x;
+    int32_t crop_y;
+    int32_t crop_width;
+    int32_t crop_height;
+} RequestHeader;
+
+typedef enum ResponseStatus {
+    STATUS_OK,
+    STATUS_BAD_REQUEST,
+    STATUS_RENDER_FAILED
+} ResponseStatus;
+
+typedef struct ResponseHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t length;
+} ResponseHeader;
+
+// Blocking helpers that retry on EINTR and short transfers
+bool Protocol_readFull(int fd, void* bytes, size_t length);
+bool Protocol_writeFull(int fd, const void* bytes, size_t length);
+
+// Fills the config part of `header` (charset excluded, it travels after it)
+void Protocol_encodeConfig(const ASCIIGenConfig* config, RequestHeader* header);
+
+// Validates `header` and rebuilds the config around `char_set`
+bool Protocol_decodeConfig(const RequestHeader* header, const char* char_set, ASCIIGenConfig* config);
+
+bool Protocol_sendResponse(int fd, ResponseStatus status, const void* body, size_t length);
+
+// Fills a sockaddr_un for `path`, false if the path does not fit
+bool Protocol_socketAddress(const char* path, struct sockaddr_un* address);
+
+#endif // PROTOCOL_H
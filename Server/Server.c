@@ -0,0 +1,530 @@
+#include "Server.h"
+
+#include <sys/sendfile.h>
+
+typedef struct Server Server;
+
+typedef enum ConnectionState {
+    CONN_READ_HEADER,
+    CONN_READ_CHARSET,
+    CONN_READ_PAYLOAD,
+    CONN_RENDERING,        // owned by a worker until it is posted back
+    CONN_WRITE
+} ConnectionState;
+
+typedef struct Connection {
+    EventSource source;
+    Server* server;
+    ConnectionState state;
+    size_t received;                // bytes of the part being read
+
+    RequestHeader header;
+    char char_set[PROTOCOL_MAX_CHARSET + 1];
+    unsigned char* payload;         // path or encoded image
+
+    ResponseHeader response;
+    char* body;                     // malloc'd output, or NULL
+    const char* error;              // static error text, or NULL
+    int entry_fd;                   // cache hit streamed with sendfile, or -1
+    off_t entry_offset;
+    size_t sent;                    // bytes of header + body written
+
+    struct Connection* next;        // completion list
+    struct Connection* prev_open;   // open list, touched by the loop thread only
+    struct Connection* next_open;
+} Connection;
+
+typedef struct ServerWorker {
+    Server* server;
+    pthread_t thread;
+    GeneratorContext* ctx;
+} ServerWorker;
+
+struct Server {
+    EventLoop loop;
+    EventSource listener;
+    bool accepting;
+    bool draining;
+    size_t connections;
+    Connection* open;               // every accepted connection
+    RenderCache* cache;
+
+    Queue jobs;                     // complete requests for the workers
+
+    pthread_mutex_t done_lock;      // rendered connections for the loop thread
+    Connection* done;
+};
+
+static void _onConnection(EventLoop* loop, EventSource* source, uint32_t events);
+
+static void _setAccepting(Server* server, bool accepting) {
+    if (server->accepting == accepting || server->draining) return;
+
+    EventLoop_modify(&server->loop, &server->listener, accepting ? EPOLLIN : 0);
+    server->accepting = accepting;
+}
+
+static void _closeConnection(Connection* conn) {
+    Server* server = conn->server;
+
+    EventLoop_remove(&server->loop, &conn->source);
+    close(conn->source.fd);
+    if (conn->entry_fd >= 0) close(conn->entry_fd);
+    free(conn->payload);
+    free(conn->body);
+
+    if (conn->prev_open) conn->prev_open->next_open = conn->next_open;
+    else server->open = conn->next_open;
+    if (conn->next_open) conn->next_open->prev_open = conn->prev_open;
+    free(conn);
+
+    server->connections--;
+    if (server->draining && server->connections == 0)
+        EventLoop_stop(&server->loop);
+    else
+        _setAccepting(server, true);
+}
+
+// ---- worker side ----------------------------------------------------------
+
+static inline void _fail(Connection* conn, ResponseStatus status, const char* message) {
+    conn->response.status = status;
+    conn->error = message;
+}
+
+static void _render(ServerWorker* worker, Connection* conn, const unsigned char* bytes, size_t length,
+                    const ASCIIGenConfig* cfg) {
+    RenderCache* cache = worker->server->cache;
+
+    CacheKey key;
+    bool cacheable = cache && Generator_computeCacheKey(bytes, length, cfg, &key);
+
+    if (cacheable) {
+        uint64_t size;
+        conn->entry_fd = Cache_openEntry(cache, &key, &size);
+        if (conn->entry_fd >= 0) {
+            conn->response.length = size;
+            return;
+        }
+    }
+
+    Image* img = Image_loadFromMemory(bytes, length);
+    if (!img) {
+        _fail(conn, STATUS_BAD_REQUEST, "cannot decode image");
+        return;
+    }
+
+    size_t written = 0;
+    conn->body = Generator_generateASCIIToMemory(worker->ctx, img, &written, cfg);
+    Image_free(img);
+    free(img);
+
+    if (!conn->body) {
+        _fail(conn, STATUS_RENDER_FAILED, "render failed");
+        return;
+    }
+
+    conn->response.length = written;
+    if (cacheable)
+        Cache_storeBytes(cache, &key, conn->body, written);
+}
+
+static void _process(ServerWorker* worker, Connection* conn) {
+    ASCIIGenConfig cfg;
+    if (!Protocol_decodeConfig(&conn->header, conn->char_set, &cfg)) {
+        _fail(conn, STATUS_BAD_REQUEST, "invalid config");
+        return;
+    }
+
+    size_t length = (size_t)conn->header.payload_length;
+
+    if (conn->header.source == SOURCE_BYTES) {
+        _render(worker, conn, conn->payload, length, &cfg);
+        return;
+    }
+
+    // paths are opened here so slow storage only stalls this worker
+    conn->payload[length] = '\0';
+    int in_fd = open((const char*)conn->payload, O_RDONLY);
+    struct stat st;
+    if (in_fd < 0 || fstat(in_fd, &st) != 0 || st.st_size <= 0) {
+        if (in_fd >= 0) close(in_fd);
+        _fail(conn, STATUS_BAD_REQUEST, "cannot read input file");
+        return;
+    }
+
+    size_t size = (size_t)st.st_size;
+    unsigned char* bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+    close(in_fd);
+    if (bytes == MAP_FAILED) {
+        _fail(conn, STATUS_BAD_REQUEST, "cannot read input file");
+        return;
+    }
+
+    _render(worker, conn, bytes, size, &cfg);
+    munmap(bytes, size);
+}
+
+static void* _workerMain(void* arg) {
+    ServerWorker* worker = arg;
+    Server* server = worker->server;
+
+    Connection* conn;
+    while ((conn = Queue_pop(&server->jobs)) != NULL) {
+        _process(worker, conn);
+
+        pthread_mutex_lock(&server->done_lock);
+        conn->next = server->done;
+        server->done = conn;
+        pthread_mutex_unlock(&server->done_lock);
+
+        EventLoop_wake(&server->loop);
+    }
+
+    return NULL;
+}
+
+// ---- loop side ------------------------------------------------------------
+
+// Reads up to `length` bytes of the current part; true once it is complete
+static bool _readPart(Connection* conn, void* target, size_t length, bool* closed) {
+    while (conn->received < length) {
+        ssize_t got = read(conn->source.fd, (unsigned char*)target + conn->received, length - conn->received);
+        if (got > 0) {
+            conn->received += (size_t)got;
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+
+        *closed = true;
+        return false;
+    }
+
+    conn->received = 0;
+    return true;
+}
+
+static void _respondNow(Connection* conn, ResponseStatus status, const char* message) {
+    _fail(conn, status, message);
+    conn->response.length = strlen(message);
+    conn->state = CONN_WRITE;
+    EventLoop_modify(&conn->server->loop, &conn->source, EPOLLOUT);
+}
+
+// Advances the request state machine; returns false when the peer is gone
+static bool _readRequest(Connection* conn) {
+    bool closed = false;
+
+    if (conn->state == CONN_READ_HEADER) {
+        if (!_readPart(conn, &conn->header, sizeof(conn->header), &closed))
+            return !closed;
+
+        const RequestHeader* h = &conn->header;
+        if (h->magic != PROTOCOL_MAGIC || h->version != PROTOCOL_VERSION) {
+            _respondNow(conn, STATUS_BAD_REQUEST, "unsupported protocol");
+            return true;
+        }
+        if (h->charset_length == 0 || h->charset_length > PROTOCOL_MAX_CHARSET ||
+            h->payload_length == 0 || h->payload_length > PROTOCOL_MAX_PAYLOAD ||
+            (h->source == SOURCE_PATH && h->payload_length >= PATH_MAX) ||
+            h->source > SOURCE_BYTES) {
+            _respondNow(conn, STATUS_BAD_REQUEST, "request too large or malformed");
+            return true;
+        }
+
+        // one spare byte terminates paths
+        conn->payload = malloc((size_t)h->payload_length + 1);
+        if (!conn->payload) {
+            _respondNow(conn, STATUS_RENDER_FAILED, "out of memory");
+            return true;
+        }
+
+        conn->state = CONN_READ_CHARSET;
+    }
+
+    if (conn->state == CONN_READ_CHARSET) {
+        if (!_readPart(conn, conn->char_set, conn->header.charset_length, &closed))
+            return !closed;
+
+        conn->char_set[conn->header.charset_length] = '\0';
+        conn->state = CONN_READ_PAYLOAD;
+    }
+
+    if (conn->state == CONN_READ_PAYLOAD) {
+        if (!_readPart(conn, conn->payload, (size_t)conn->header.payload_length, &closed))
+            return !closed;
+
+        // unregistered while rendering: a hangup would otherwise be reported
+        // on every wait. The connection count caps the queue, so this never blocks
+        conn->state = CONN_RENDERING;
+        EventLoop_remove(&conn->server->loop, &conn->source);
+        Queue_push(&conn->server->jobs, conn);
+    }
+
+    return true;
+}
+
+// Writes as much of the response as the socket takes; true once it is all out
+static bool _writeResponse(Connection* conn, bool* failed) {
+    size_t header_size = sizeof(conn->response);
+    size_t total = header_size + (size_t)conn->response.length;
+
+    while (conn->sent < total) {
+        ssize_t put;
+
+        if (conn->sent < header_size) {
+            put = send(conn->source.fd, (const char*)&conn->response + conn->sent,
+                       header_size - conn->sent, MSG_NOSIGNAL);
+        } else if (conn->entry_fd >= 0) {
+            put = sendfile(conn->source.fd, conn->entry_fd, &conn->entry_offset, total - conn->sent);
+            if (put == 0) {
+                // the entry shrank under us, the client sees a short read
+                *failed = true;
+                return false;
+            }
+        } else {
+            const char* body = conn->body ? conn->body : conn->error;
+            put = send(conn->source.fd, body + (conn->sent - header_size),
+                       total - conn->sent, MSG_NOSIGNAL);
+        }
+
+        if (put > 0) {
+            conn->sent += (size_t)put;
+            continue;
+        }
+        if (put < 0 && errno == EINTR) continue;
+        if (put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+
+        *failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+static void _onConnection(EventLoop* loop, EventSource* source, uint32_t events) {
+    (void)loop;
+    Connection* conn = source->data;
+
+    if (conn->state == CONN_WRITE) {
+        bool failed = false;
+        if (_writeResponse(conn, &failed) || failed)
+            _closeConnection(conn);
+        return;
+    }
+
+    if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+        _closeConnection(conn);
+        return;
+    }
+
+    if (!_readRequest(conn))
+        _closeConnection(conn);
+}
+
+static void _onAccept(EventLoop* loop, EventSource* source, uint32_t events) {
+    (void)events;
+    Server* server = source->data;
+
+    while (server->connections < SERVER_MAX_CONNECTIONS) {
+        int fd = accept(source->fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                fprintf(stderr, "Server: accept failed: %s.\n", strerror(errno));
+            return;
+        }
+
+        Connection* conn = EventLoop_setNonBlocking(fd) ? calloc(1, sizeof(Connection)) : NULL;
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+
+        conn->source = (EventSource){ .fd = fd, .handler = _onConnection, .data = conn };
+        conn->server = server;
+        conn->state = CONN_READ_HEADER;
+        conn->entry_fd = -1;
+        conn->response.magic = PROTOCOL_MAGIC;
+        conn->response.status = STATUS_OK;
+
+        if (!EventLoop_add(loop, &conn->source, EPOLLIN | EPOLLRDHUP)) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+
+        conn->next_open = server->open;
+        if (server->open) server->open->prev_open = conn;
+        server->open = conn;
+        server->connections++;
+    }
+
+    // backpressure: stop accepting until a connection finishes
+    _setAccepting(server, false);
+}
+
+// Clients that never started a request would hold a draining server open
+// forever; the ones midway through a request are left to finish it
+static void _closeIdleConnections(Server* server) {
+    Connection* conn = server->open;
+    while (conn) {
+        Connection* next = conn->next_open;
+        if (conn->state == CONN_READ_HEADER && conn->received == 0)
+            _closeConnection(conn);
+        conn = next;
+    }
+}
+
+// Rendered connections come back here; they switch to writing and are served
+// by their own handler once the socket drains
+static void _onRendered(EventLoop* loop, EventSource* source, uint32_t events) {
+    (void)events;
+    Server* server = source->data;
+
+    pthread_mutex_lock(&server->done_lock);
+    Connection* conn = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->done_lock);
+
+    while (conn) {
+        Connection* next = conn->next;
+
+        if (conn->error)
+            conn->response.length = strlen(conn->error);
+
+        conn->state = CONN_WRITE;
+        if (!EventLoop_add(loop, &conn->source, EPOLLOUT))
+            _closeConnection(conn);
+
+        conn = next;
+    }
+}
+
+// Binds `path`, replacing a stale socket file but never a live server
+static int _listen(const char* path) {
+    struct sockaddr_un address;
+    if (!Protocol_socketAddress(path, &address))
+        return -1;
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        bool live = connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0;
+        close(probe);
+        if (live) {
+            fprintf(stderr, "Server: %s is already served.\n", path);
+            return -1;
+        }
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 ||
+        bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(fd, SERVER_BACKLOG) != 0) {
+        fprintf(stderr, "Server: cannot listen on %s: %s.\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void _onSignal(int signal) {
+    (void)signal;
+}
+
+bool Server_run(const ServerOptions* options) {
+    if (!options || !options->socket_path) return false;
+
+    int threads = options->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > SERVER_MAX_THREADS) threads = SERVER_MAX_THREADS;
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.cache = options->cache;
+
+    int listen_fd = _listen(options->socket_path);
+    if (listen_fd < 0)
+        return false;
+
+    if (!EventLoop_init(&server.loop, _onRendered, &server) || !Queue_init(&server.jobs, SERVER_MAX_CONNECTIONS)) {
+        EventLoop_release(&server.loop);
+        close(listen_fd);
+        return false;
+    }
+    pthread_mutex_init(&server.done_lock, NULL);
+
+    // SIGINT/SIGTERM stay blocked (workers inherit that) and are only
+    // delivered inside epoll_pwait, so a shutdown request cannot be missed
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = _onSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    sigset_t blocked, wait_mask;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &wait_mask);
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    ServerWorker workers[SERVER_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    int started = 0;
+
+    for (; started < threads; started++) {
+        ServerWorker* worker = &workers[started];
+        worker->server = &server;
+        worker->ctx = GeneratorContext_create();
+        if (!worker->ctx || pthread_create(&worker->thread, NULL, _workerMain, worker) != 0) {
+            GeneratorContext_free(worker->ctx);
+            break;
+        }
+    }
+
+    server.listener = (EventSource){ .fd = listen_fd, .handler = _onAccept, .data = &server };
+    bool listening = started > 0 && EventLoop_add(&server.loop, &server.listener, EPOLLIN);
+    server.accepting = listening;
+
+    if (listening) {
+        fprintf(stderr, "Server: listening on %s with %d workers.\n", options->socket_path, started);
+
+        while (EventLoop_run(&server.loop, &wait_mask) == EINTR) {
+            if (server.draining) continue;
+
+            // stop taking connections, let the requests in progress finish
+            EventLoop_remove(&server.loop, &server.listener);
+            server.accepting = false;
+            server.draining = true;
+            _closeIdleConnections(&server);
+            if (server.connections == 0)
+                break;
+        }
+    } else {
+        fprintf(stderr, "Server: failed to start workers.\n");
+    }
+
+    Queue_close(&server.jobs);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        GeneratorContext_free(workers[i].ctx);
+    }
+
+    close(listen_fd);
+    unlink(options->socket_path);
+
+    pthread_sigmask(SIG_SETMASK, &wait_mask, NULL);
+    pthread_mutex_destroy(&server.done_lock);
+    Queue_destroy(&server.jobs);
+    EventLoop_release(&server.loop);
+
+    return listening;
+}
@@ -0,0 +1,47 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "Protocol.h"
+#include "../Cache/Cache.h"
+#include "../IO/EventLoop.h"
+#include "../IO/Queue.h"
+#include "../Generator/Generator.h"
+
+#define SERVER_MAX_THREADS    64
+#define SERVER_BACKLOG        64
+
+// Open connections; accept pauses at the limit, which bounds the memory held
+// by buffered request payloads and rendered responses
+#define SERVER_MAX_CONNECTIONS 256
+
+typedef struct ServerOptions {
+    const char* socket_path;
+    int threads;            // 0 starts one worker per online CPU
+    RenderCache* cache;     // optional, shared by every worker
+} ServerOptions;
+
+// Listens on `socket_path` and renders requests (see Protocol.h) until SIGINT
+// or SIGTERM, then finishes the requests in flight and drops idle clients.
+// One epoll thread does all socket I/O without blocking: it assembles requests,
+// hands complete ones to a pool of render workers (each owning a
+// GeneratorContext) and writes the responses back as the sockets drain, so
+// slow clients never hold a worker. Returns false if the socket could not be set up.
+bool Server_run(const ServerOptions* options);
+
+#endif // SERVER_H
@@ -0,0 +1,63 @@
+#include "Stats.h"
+
+_Thread_local uint64_t stats_thread_allocations = 0;
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {
+    "cache",
+    "decode",
+    "grayscale",
+    "edges",
+    "dither",
+    "sample",
+    "raster",
+    "encode"
+};
+
+const char* Stats_stageName(RenderStage stage) {
+    return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+void Stats_reset(RenderStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(RenderStats));
+}
+
+void Stats_merge(RenderStats* into, const RenderStats* from) {
+    if (!into || !from) return;
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        into->stages[i].calls += from->stages[i].calls;
+        into->stages[i].nanoseconds += from->stages[i].nanoseconds;
+        into->stages[i].bytes += from->stages[i].bytes;
+        into->stages[i].allocations += from->stages[i].allocations;
+    }
+}
+
+static inline void _printLine(FILE* output, const char* name, const StageStats* s) {
+    double ms = (double)s->nanoseconds / 1e6;
+    double mb = (double)s->bytes / (1024.0 * 1024.0);
+    double rate = s->nanoseconds > 0 ? mb / ((double)s->nanoseconds / 1e9) : 0.0;
+
+    fprintf(output, "%-10s %8llu %12.3f %12.2f %10.1f %8llu\n", name,
+            (unsigned long long)s->calls, ms, mb, rate, (unsigned long long)s->allocations);
+}
+
+void Stats_print(const RenderStats* stats, FILE* output) {
+    if (!stats || !output) return;
+
+    fprintf(output, "%-10s %8s %12s %12s %10s %8s\n", "stage", "calls", "ms", "MB", "MB/s", "allocs");
+
+    StageStats total = { 0 };
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const StageStats* s = &stats->stages[i];
+        if (s->calls == 0) continue;
+
+        _printLine(output, STAGE_NAMES[i], s);
+        total.nanoseconds += s->nanoseconds;
+        total.allocations += s->allocations;
+    }
+
+    // bytes of different stages are not comparable, so the total has none
+    fprintf(output, "%-10s %8s %12.3f %12s %10s %8llu\n", "total", "",
+            (double)total.nanoseconds / 1e6, "", "", (unsigned long long)total.allocations);
+}
@@ -0,0 +1,107 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+typedef enum RenderStage {
+    STAGE_CACHE,        // cache key hashing and lookups
+    STAGE_DECODE,       // Image_load / Image_loadFromMemory
+    STAGE_GRAYSCALE,    // Image_toGrayscale
+    STAGE_EDGES,        // Sobel, run in the same tiled pass as grayscale (see Stats_endShared)
+    STAGE_DITHER,       // Floyd-Steinberg
+    STAGE_SAMPLE,       // cells into the Grid (brightness, sub-cell or shape)
+    STAGE_RASTER,       // text rasterized for PNG output
+    STAGE_ENCODE,       // Grid to text/ANSI/HTML/SVG, or raster to PNG, and its writes
+    STAGE_COUNT
+} RenderStage;
+
+typedef struct StageStats {
+    uint64_t calls;
+    uint64_t nanoseconds;   // wall time, monotonic clock
+    uint64_t bytes;         // input the stage read (decode: the pixels it produced)
+    uint64_t allocations;   // heap allocations made by the library during the stage
+} StageStats;
+
+// Per-stage totals, accumulated over every render that points at it through
+// ASCIIGenConfig.stats. A render without one never reads the clock.
+// A RenderStats must not be shared by renders running at the same time.
+typedef struct RenderStats {
+    StageStats stages[STAGE_COUNT];
+} RenderStats;
+
+typedef struct StatsTimer {
+    uint64_t start;
+    uint64_t allocations;
+} StatsTimer;
+
+// Heap allocations made by the library on the calling thread
+extern _Thread_local uint64_t stats_thread_allocations;
+
+// Call next to every library heap allocation
+static inline void Stats_countAllocations(uint64_t count) {
+    stats_thread_allocations += count;
+}
+
+static inline uint64_t Stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void Stats_begin(const RenderStats* stats, StatsTimer* timer) {
+    if (!stats) return;
+
+    timer->allocations = stats_thread_allocations;
+    timer->start = Stats_now();
+}
+
+static inline void Stats_end(RenderStats* stats, const StatsTimer* timer, RenderStage stage, uint64_t bytes) {
+    if (!stats) return;
+
+    StageStats* s = &stats->stages[stage];
+    s->nanoseconds += Stats_now() - timer->start;
+    s->allocations += stats_thread_allocations - timer->allocations;
+    s->bytes += bytes;
+    s->calls++;
+}
+
+// Ends a pass that ran `stage` and `other` interleaved (e.g. in the same
+// tiles): its wall time is shared between them in the ratio of `weight` to
+// `other_weight`, the thread time each measured on its own
+static inline void Stats_endShared(RenderStats* stats, const StatsTimer* timer,
+                                   RenderStage stage, uint64_t bytes, uint64_t weight,
+                                   RenderStage other, uint64_t other_bytes, uint64_t other_weight) {
+    if (!stats) return;
+
+    uint64_t elapsed = Stats_now() - timer->start;
+    uint64_t total = weight + other_weight;
+    uint64_t other_ns = total > 0 ? (uint64_t)((double)elapsed * other_weight / total) : 0;
+
+    StageStats* s = &stats->stages[stage];
+    s->nanoseconds += elapsed - other_ns;
+    s->allocations += stats_thread_allocations - timer->allocations;
+    s->bytes += bytes;
+    s->calls++;
+
+    StageStats* o = &stats->stages[other];
+    o->nanoseconds += other_ns;
+    o->bytes += other_bytes;
+    o->calls++;
+}
+
+const char* Stats_stageName(RenderStage stage);
+
+void Stats_reset(RenderStats* stats);
+
+// Adds every counter of `from` to `into`
+void Stats_merge(RenderStats* into, const RenderStats* from);
+
+// Prints one line per stage that ran, plus the total
+void Stats_print(const RenderStats* stats, FILE* output);
+
+#endif // STATS_H
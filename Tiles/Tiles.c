@@ -0,0 +1,114 @@
+#include "Tiles.h"
+
+static void _runTiles(TilePool* pool, int worker) {
+    for (;;) {
+        int tile = __atomic_fetch_add(&pool->next_tile, 1, __ATOMIC_RELAXED);
+        if (tile >= pool->tile_count) break;
+        pool->func(pool->arg, tile, worker);
+    }
+}
+
+static void* _helperMain(void* arg) {
+    TileHelper* helper = arg;
+    TilePool* pool = helper->pool;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen)
+            pthread_cond_wait(&pool->posted, &pool->lock);
+        if (pool->stopping) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        _runTiles(pool, helper->worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->drained);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+void Tiles_init(TilePool* pool, int threads) {
+    memset(pool, 0, sizeof(TilePool));
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > TILES_MAX_THREADS) threads = TILES_MAX_THREADS;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->posted, NULL);
+    pthread_cond_init(&pool->drained, NULL);
+    pool->ready = true;
+
+    for (int i = 0; i < threads - 1; i++) {
+        TileHelper* helper = &pool->helpers[i];
+        helper->pool = pool;
+        helper->worker = i + 1;
+        if (pthread_create(&helper->thread, NULL, _helperMain, helper) != 0) {
+            fprintf(stderr, "Tiles: started %d of %d helper threads.\n", i, threads - 1);
+            break;
+        }
+        pool->helper_count++;
+    }
+}
+
+void Tiles_destroy(TilePool* pool) {
+    if (!pool->ready) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->posted);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->helper_count; i++)
+        pthread_join(pool->helpers[i].thread, NULL);
+
+    pthread_cond_destroy(&pool->drained);
+    pthread_cond_destroy(&pool->posted);
+    pthread_mutex_destroy(&pool->lock);
+
+    memset(pool, 0, sizeof(TilePool));
+}
+
+int Tiles_workers(const TilePool* pool) {
+    return pool ? pool->helper_count + 1 : 1;
+}
+
+int Tiles_bandRows(size_t row_bytes, int halo) {
+    size_t rows = TILES_BAND_BYTES / (row_bytes > 0 ? row_bytes : 1);
+    rows = rows > (size_t)(2 * halo) ? rows - 2 * halo : 0;
+
+    if (rows < TILES_MIN_BAND_ROWS) return TILES_MIN_BAND_ROWS;
+    return rows > (size_t)INT_MAX ? INT_MAX : (int)rows;
+}
+
+void Tiles_run(TilePool* pool, int tile_count, TileFunc func, void* arg) {
+    // one tile is not worth waking anyone for
+    if (!pool || pool->helper_count == 0 || tile_count <= 1) {
+        for (int tile = 0; tile < tile_count; tile++)
+            func(arg, tile, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->arg = arg;
+    pool->tile_count = tile_count;
+    pool->next_tile = 0;
+    pool->active = pool->helper_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->posted);
+    pthread_mutex_unlock(&pool->lock);
+
+    _runTiles(pool, 0);
+
+    // helpers that woke late still pass through the job, so none can miss the next one
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->drained, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,90 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TILES_MAX_THREADS   64
+
+// Bytes a band should touch (its input and output rows, halo included), so
+// every stage run on it after the first finds its rows still in L2; half of
+// a 1 MiB L2 leaves room for everything else
+#define TILES_BAND_BYTES    (512 * 1024)
+#define TILES_MIN_BAND_ROWS 16
+
+// Runs tile `tile` of a job; `worker` (0 for the calling thread) is below
+// Tiles_workers of the pool, so each worker can own a slice of scratch memory
+typedef void (*TileFunc)(void* arg, int tile, int worker);
+
+typedef struct TilePool TilePool;
+
+typedef struct TileHelper {
+    TilePool* pool;
+    int worker;
+    pthread_t thread;
+} TileHelper;
+
+// Fixed set of threads that run the tiles of one job at a time, handing them
+// out in order from a shared counter. The thread that posts a job works on it
+// too and returns once every tile is done. A pool must not be used by two
+// threads at the same time.
+struct TilePool {
+    TileHelper helpers[TILES_MAX_THREADS];
+    int helper_count;       // started helpers, workers 1 to helper_count
+    pthread_mutex_t lock;
+    pthread_cond_t posted;  // a job was posted, or the pool is stopping
+    pthread_cond_t drained; // the last helper left the job
+    TileFunc func;
+    void* arg;
+    int tile_count;
+    int next_tile;          // taken with an atomic add
+    int active;             // helpers still inside the job
+    unsigned generation;    // bumped for every job
+    bool stopping;
+    bool ready;
+};
+
+// Starts `threads - 1` helpers (0 for one thread per online CPU); a pool of
+// one thread, or one whose helpers failed to start, runs every tile inline
+void Tiles_init(TilePool* pool, int threads);
+void Tiles_destroy(TilePool* pool);
+
+// Threads that work on a job, the caller included; 1 for a NULL pool
+int Tiles_workers(const TilePool* pool);
+
+// Runs func(arg, tile, worker) for every tile in [0, tile_count) and waits
+// for all of them; a NULL pool runs them on the calling thread
+void Tiles_run(TilePool* pool, int tile_count, TileFunc func, void* arg);
+
+// Rows [y0, y1) of an image, plus the `halo` rows around them a neighborhood
+// filter reads, clipped to the image: [halo_y0, halo_y1)
+typedef struct TileBand {
+    int y0;
+    int y1;
+    int halo_y0;
+    int halo_y1;
+} TileBand;
+
+// Rows per band so that a band and its halo touch about TILES_BAND_BYTES
+// when each row costs `row_bytes` over all the stages run on it
+int Tiles_bandRows(size_t row_bytes, int halo);
+
+static inline int Tiles_bandCount(int height, int band_rows) {
+    return (height + band_rows - 1) / band_rows;
+}
+
+static inline TileBand Tiles_band(int height, int band_rows, int halo, int index) {
+    TileBand band;
+    band.y0 = index * band_rows;
+    band.y1 = band.y0 + band_rows < height ? band.y0 + band_rows : height;
+    band.halo_y0 = band.y0 - halo > 0 ? band.y0 - halo : 0;
+    band.halo_y1 = band.y1 + halo < height ? band.y1 + halo : height;
+    return band;
+}
+
+#endif // TILES_H
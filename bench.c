@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+
+#include "Bench/Corpus.h"
+#include "Generator/Generator.h"
+#include "Image/Image.h"
+#include "Kernels/Kernels.h"
+
+#define BENCH_MAX_SIZES 16
+
+typedef struct BenchConfig {
+    const char* name;
+    ColorMode color;
+    DitherMode dither;
+    EdgeMode edge;
+    bool fixed_point;
+    bool linear_light;
+    SamplingMode sampling;
+    ImageLayout layout;
+    int crop;       // renders only the centered block 1 / crop of the width and height, 0 for all of it
+} BenchConfig;
+
+static const BenchConfig BENCH_CONFIGS[] = {
+    { "gray",         COLOR_NONE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "16",           COLOR_16,   DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "256",          COLOR_256,  DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "true",         COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "dither",       COLOR_NONE, DITHER_FLOYD_STEINBERG, EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "edges",        COLOR_NONE, DITHER_NONE,            EDGE_SOBEL, false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "fixed",        COLOR_NONE, DITHER_NONE,            EDGE_NONE,  true,  false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "fixed-true",   COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  true,  false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "fixed-dither", COLOR_NONE, DITHER_FLOYD_STEINBERG, EDGE_NONE,  true,  false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "linear",       COLOR_NONE, DITHER_NONE,            EDGE_NONE,  false, true,  SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "linear-true",  COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, true,  SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 0 },
+    { "area",         COLOR_NONE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_AREA,     IMAGE_INTERLEAVED, 0 },
+    { "area-true",    COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_AREA,     IMAGE_INTERLEAVED, 0 },
+    { "triangle",     COLOR_NONE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_TRIANGLE, IMAGE_INTERLEAVED, 0 },
+    { "lanczos",      COLOR_NONE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_LANCZOS,  IMAGE_INTERLEAVED, 0 },
+    { "lanczos-true", COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_LANCZOS,  IMAGE_INTERLEAVED, 0 },
+    { "planar-true",  COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_PLANAR,      0 },
+    { "crop-true",    COLOR_TRUE, DITHER_NONE,            EDGE_NONE,  false, false, SAMPLING_BLOCK,    IMAGE_INTERLEAVED, 4 },
+};
+
+#define BENCH_CONFIG_COUNT (int)(sizeof(BENCH_CONFIGS) / sizeof(BENCH_CONFIGS[0]))
+
+static const int DEFAULT_SIZES[] = { 256, 512, 1024, 2048, 4096, 8192 };
+
+typedef struct BenchOptions {
+    int sizes[BENCH_MAX_SIZES];
+    int size_count;
+    const char* patterns;       // comma separated, NULL for all
+    const char* configs;        // comma separated, NULL for all
+    int iterations;
+    double max_seconds;         // per case, after the first few runs
+    int columns;
+    int threads;                // tile workers per render, as ASCIIGenConfig.threads
+    bool csv;
+    bool cpu_levels[CPU_LEVEL_COUNT];   // kernel levels each case runs with
+} BenchOptions;
+
+static struct option long_options[] = {
+    { "sizes",       required_argument, 0, 's' },
+    { "patterns",    required_argument, 0, 'p' },
+    { "configs",     required_argument, 0, 'c' },
+    { "iterations",  required_argument, 0, 'n' },
+    { "max-seconds", required_argument, 0, 't' },
+    { "columns",     required_argument, 0, 'W' },
+    { "threads",     required_argument, 0, 'T' },
+    { "csv",         no_argument,       0, 'x' },
+    { "cpu",         required_argument, 0, 'k' },
+    { "help",        no_argument,       0, 'h' },
+    { 0, 0, 0, 0 }
+};
+
+static inline double _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int _compareDoubles(const void* a, const void* b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted samples
+static inline double _percentile(const double* sorted, int count, double p) {
+    int rank = (int)(p * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// True when `name` is in the comma separated `list` (NULL selects everything)
+static bool _selected(const char* list, const char* name) {
+    if (!list) return true;
+
+    size_t len = strlen(name);
+    for (const char* p = list; *p; ) {
+        const char* end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, name, n) == 0) return true;
+        if (!end) break;
+        p = end + 1;
+    }
+    return false;
+}
+
+static bool _parseSizes(const char* arg, BenchOptions* options) {
+    options->size_count = 0;
+
+    for (const char* p = arg; *p; ) {
+        char* end;
+        long size = strtol(p, &end, 10);
+        if (end == p || size <= 0 || size > 65536 || options->size_count == BENCH_MAX_SIZES)
+            return false;
+
+        options->sizes[options->size_count++] = (int)size;
+        if (*end == '\0') break;
+        if (*end != ',') return false;
+        p = end + 1;
+    }
+
+    return options->size_count > 0;
+}
+
+// Comma separated kernel levels, each supported by this CPU
+static bool _parseCpuLevels(const char* arg, BenchOptions* options) {
+    memset(options->cpu_levels, 0, sizeof(options->cpu_levels));
+
+    bool any = false;
+    CpuLevel supported = Kernels_detect();
+    for (int l = 0; l < CPU_LEVEL_COUNT; l++) {
+        if (!_selected(arg, Kernels_levelName((CpuLevel)l))) continue;
+        if (l > (int)supported) {
+            fprintf(stderr, "Bench: this CPU does not support %s.\n", Kernels_levelName((CpuLevel)l));
+            return false;
+        }
+        options->cpu_levels[l] = any = true;
+    }
+
+    return any;
+}
+
+static void _printHeader(const BenchOptions* options) {
+    if (options->csv)
+        printf("pattern,width,height,config,cpu,threads,columns,rows,iterations,median_ms,p99_ms,min_ms,input_mb_per_s,output_bytes\n");
+}
+
+static void _printResult(const BenchOptions* options, CorpusPattern pattern, const Image* img,
+                         const BenchConfig* config, int columns, int rows,
+                         const double* sorted, int count, size_t output_bytes) {
+    double median = _percentile(sorted, count, 0.5);
+    double p99 = _percentile(sorted, count, 0.99);
+    double input_mb = (double)img->width * img->height * img->channels / (1024.0 * 1024.0);
+
+    const char* cpu = Kernels_levelName(Kernels_get()->level);
+
+    if (options->csv) {
+        printf("%s,%d,%d,%s,%s,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.2f,%zu\n",
+               Corpus_patternName(pattern), img->width, img->height, config->name, cpu, options->threads, columns, rows,
+               count, median * 1e3, p99 * 1e3, sorted[0] * 1e3, input_mb / median, output_bytes);
+    } else {
+        printf("{\"pattern\":\"%s\",\"width\":%d,\"height\":%d,\"config\":\"%s\",\"cpu\":\"%s\",\"threads\":%d,\"columns\":%d,\"rows\":%d,"
+               "\"iterations\":%d,\"median_ms\":%.4f,\"p99_ms\":%.4f,\"min_ms\":%.4f,"
+               "\"input_mb_per_s\":%.2f,\"output_bytes\":%zu}\n",
+               Corpus_patternName(pattern), img->width, img->height, config->name, cpu, options->threads, columns, rows,
+               count, median * 1e3, p99 * 1e3, sorted[0] * 1e3, input_mb / median, output_bytes);
+    }
+    fflush(stdout);
+}
+
+static bool _runCase(const BenchOptions* options, GeneratorContext* ctx, CorpusPattern pattern,
+                     Image* img, const BenchConfig* config, double* samples) {
+    ASCIIGenConfig cfg = DEFAULT_CONFIG;
+    cfg.color_mode = config->color;
+    cfg.dither_mode = config->dither;
+    cfg.edge_mode = config->edge;
+    cfg.fixed_point = config->fixed_point;
+    cfg.linear_light = config->linear_light;
+    cfg.sampling = config->sampling;
+    cfg.output_format = FORMAT_TEXT;
+    cfg.columns = options->columns;
+    cfg.threads = options->threads;
+    if (config->crop > 0) {
+        int width = img->width / config->crop > 0 ? img->width / config->crop : 1;
+        int height = img->height / config->crop > 0 ? img->height / config->crop : 1;
+        cfg.crop = (ImageRect){ (img->width - width) / 2, (img->height - height) / 2, width, height };
+    }
+
+    int columns, rows;
+    Generator_computeGridSize(img, &cfg, &columns, &rows);
+
+    size_t capacity = Generator_queryOutputSize(&cfg, columns, rows);
+    char* buffer = malloc(capacity);
+    if (!buffer) {
+        fprintf(stderr, "Bench: failed to allocate %zu bytes.\n", capacity);
+        return false;
+    }
+
+    // one untimed run warms the context, caches and branch predictors
+    size_t written = 0;
+    bool success = Generator_generateASCIIToBuffer(ctx, img, buffer, capacity, &written, &cfg);
+
+    int count = 0;
+    double started = _now();
+    while (success && count < options->iterations) {
+        double t0 = _now();
+        success = Generator_generateASCIIToBuffer(ctx, img, buffer, capacity, &written, &cfg);
+        samples[count++] = _now() - t0;
+
+        // large images stop early, but always get enough runs for a median
+        if (count >= 3 && _now() - started > options->max_seconds) break;
+    }
+    free(buffer);
+
+    if (!success) {
+        fprintf(stderr, "Bench: %s %dx%d %s failed.\n", Corpus_patternName(pattern),
+                img->width, img->height, config->name);
+        return false;
+    }
+
+    qsort(samples, count, sizeof(double), _compareDoubles);
+    _printResult(options, pattern, img, config, columns, rows, samples, count, written);
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = {
+        .patterns = NULL,
+        .configs = NULL,
+        .iterations = 25,
+        .max_seconds = 2.0,
+        .columns = 160,
+        .threads = 1,
+        .csv = false,
+    };
+    memcpy(options.sizes, DEFAULT_SIZES, sizeof(DEFAULT_SIZES));
+    // GENSCII_CPU already applies to the level picked by default
+    options.cpu_levels[Kernels_get()->level] = true;
+    options.size_count = (int)(sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]));
+
+    int opt;
+    int long_index = 0;
+    while ((opt = getopt_long(argc, argv, "s:p:c:n:t:W:T:xk:h", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case 's':
+                if (!_parseSizes(optarg, &options)) {
+                    printf("%s is not a valid size list.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'p':
+                options.patterns = optarg;
+                break;
+            case 'c':
+                options.configs = optarg;
+                break;
+            case 'n':
+                options.iterations = atoi(optarg);
+                if (options.iterations <= 0) {
+                    printf("%s is not a valid iteration count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                options.max_seconds = atof(optarg);
+                if (options.max_seconds <= 0.0) {
+                    printf("%s is not a valid time limit.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'W':
+                options.columns = atoi(optarg);
+                if (options.columns <= 0) {
+                    printf("%s is not a valid column count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                options.threads = atoi(optarg);
+                if (options.threads < 0) {
+                    printf("%s is not a valid thread count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'x':
+                options.csv = true;
+                break;
+            case 'k':
+                if (!_parseCpuLevels(optarg, &options)) {
+                    printf("%s is not a valid kernel level list.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'h':
+                printf("Usage: %s [--sizes N,N,...] [--patterns gradient,noise,photo] [--configs gray,16,256,true,dither,edges,fixed,fixed-true,fixed-dither,linear,linear-true,area,area-true,triangle,lanczos,lanczos-true,planar-true,crop-true] [--iterations N] [--max-seconds S] [--columns N] [--threads N] [--csv] [--cpu scalar,sse2,sse4.1,avx2,avx512]\n", argv[0]);
+                printf("Prints one JSON object (or CSV row) per pattern, size and configuration to stdout.\n");
+                return 0;
+            default:
+                fprintf(stderr, "Try '%s -h' for help.\n", argv[0]);
+                return 1;
+        }
+    }
+
+    double* samples = malloc(sizeof(double) * options.iterations);
+    GeneratorContext* ctx = GeneratorContext_create();
+    if (!samples || !ctx) {
+        fprintf(stderr, "Bench: failed to set up.\n");
+        return 1;
+    }
+
+    _printHeader(&options);
+
+    bool success = true;
+    for (int s = 0; s < options.size_count; s++) {
+        for (int p = 0; p < PATTERN_COUNT; p++) {
+            CorpusPattern pattern = (CorpusPattern)p;
+            if (!_selected(options.patterns, Corpus_patternName(pattern))) continue;
+
+            int size = options.sizes[s];
+            Image* img = Corpus_generate(pattern, size, size, CORPUS_DEFAULT_SEED);
+            if (!img) {
+                fprintf(stderr, "Bench: cannot generate a %dx%d %s image.\n", size, size, Corpus_patternName(pattern));
+                success = false;
+                continue;
+            }
+
+            Image* planar = NULL;    // split once, the first time a planar config runs
+            for (int c = 0; c < BENCH_CONFIG_COUNT; c++) {
+                if (!_selected(options.configs, BENCH_CONFIGS[c].name)) continue;
+
+                Image* input = img;
+                if (BENCH_CONFIGS[c].layout == IMAGE_PLANAR) {
+                    if (!planar) {
+                        planar = Image_createPlanar(img->width, img->height, img->channels);
+                        if (!planar) {
+                            success = false;
+                            continue;
+                        }
+                        Image_toPlanarInto(img, planar);
+                    }
+                    input = planar;
+                }
+
+                for (int l = 0; l < CPU_LEVEL_COUNT; l++) {
+                    if (!options.cpu_levels[l]) continue;
+
+                    Kernels_select((CpuLevel)l);
+                    if (!_runCase(&options, ctx, pattern, input, &BENCH_CONFIGS[c], samples))
+                        success = false;
+                }
+            }
+
+            Image_free(img);
+            if (planar) {
+                Image_free(planar);
+                free(planar);
+            }
+        }
+    }
+
+    GeneratorContext_free(ctx);
+    free(samples);
+
+    return success ? 0 : 1;
+}
@@ -1,9 +1,13 @@
 #include <stdio.h>
 #include <getopt.h>
 #include <string.h>
+#include <strings.h>
 
 #include "Generator/Generator.h"
 #include "Image/Image.h"
+#include "Server/Client.h"
+#include "Server/Server.h"
+#include "Batch/Batch.h"
 
 static struct option long_options[] = {
     { "input",          required_argument, 0, 'i' },
@@ -14,29 +18,85 @@ static struct option long_options[] = {
     { "colored",        required_argument, 0, 'm' },
     { "dithering",      required_argument, 0, 'd' },
     { "edge-detection", required_argument, 0, 'e' },
+    { "glyph-mode",     required_argument, 0, 'G' },
+    { "format",         required_argument, 0, 'f' },
+    { "columns",        required_argument, 0, 'W' },
+    { "rows",           required_argument, 0, 'H' },
+    { "fixed-point",    no_argument,       0, 'X' },
+    { "linear",         no_argument,       0, 'l' },
+    { "sampling",       required_argument, 0, 'p' },
+    { "planar",         no_argument,       0, 'P' },
+    { "crop",           required_argument, 0, 'x' },
+    { "cache",          required_argument, 0, 'C' },
+    { "cache-size",     required_argument, 0, 'S' },
+    { "serve",          required_argument, 0, 'D' },
+    { "threads",        required_argument, 0, 'T' },
+    { "remote",         required_argument, 0, 'R' },
+    { "batch",          no_argument,       0, 'B' },
+    { "stats",          no_argument,       0, 's' },
     { "help",           no_argument,       0, 'h' },
     { 0, 0, 0, 0 }
 };
 
+// Picks the output format from the output file extension when --format is not given
+static OutputFormat _formatFromPath(const char* path) {
+    const char* ext = strrchr(path, '.');
+    if (!ext) return FORMAT_TEXT;
+
+    if (strcasecmp(ext, ".html") == 0 || strcasecmp(ext, ".htm") == 0)
+        return FORMAT_HTML;
+    if (strcasecmp(ext, ".svg") == 0)
+        return FORMAT_SVG;
+    if (strcasecmp(ext, ".png") == 0)
+        return FORMAT_PNG;
+
+    return FORMAT_TEXT;
+}
+
 int main(int argc, char* argv[]) {
     const char* input_path = NULL;
-    const char* output_path = NULL;
+    const char* output_paths[GENERATOR_MAX_SINKS];
+    bool output_plain[GENERATOR_MAX_SINKS];   // written without colors (-m none before its -o)
+    int output_count = 0;
+    bool plain = false;
     const char* char_set = DEFAULT_CONFIG.char_set;
     float aspect = DEFAULT_CONFIG.terminal_aspect_ratio;
     GrayscaleMethod method = DEFAULT_CONFIG.grayscale_method;
     ColorMode color = DEFAULT_CONFIG.color_mode;
     DitherMode dither = DEFAULT_CONFIG.dither_mode;
     EdgeMode edge = DEFAULT_CONFIG.edge_mode;
+    GlyphMode glyph = DEFAULT_CONFIG.glyph_mode;
+    OutputFormat format = DEFAULT_CONFIG.output_format;
+    bool format_given = false;
+    int columns = DEFAULT_CONFIG.columns;
+    int rows = DEFAULT_CONFIG.rows;
+    bool fixed_point = DEFAULT_CONFIG.fixed_point;
+    bool linear_light = DEFAULT_CONFIG.linear_light;
+    SamplingMode sampling = DEFAULT_CONFIG.sampling;
+    ImageLayout layout = DEFAULT_CONFIG.layout;
+    ImageRect crop = DEFAULT_CONFIG.crop;
+    const char* cache_dir = NULL;
+    unsigned long long cache_mb = CACHE_DEFAULT_MAX_BYTES / (1024 * 1024);
+    const char* serve_path = NULL;
+    const char* remote_path = NULL;
+    int threads = 0;
+    bool batch = false;
+    bool show_stats = false;
 
     int opt;
     int long_index = 0;
-    while ((opt = getopt_long(argc, argv, "i:o:c:a:g:m:d:e:h", long_options, &long_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:o:c:a:g:m:d:e:G:f:W:H:Xlp:Px:C:S:D:T:R:Bsh", long_options, &long_index)) != -1) {
         switch (opt) {
             case 'i':
                 input_path = optarg;
                 break;
             case 'o':
-                output_path = optarg;
+                if (output_count == GENERATOR_MAX_SINKS) {
+                    printf("At most %d outputs are supported.\n", GENERATOR_MAX_SINKS);
+                    return 1;
+                }
+                output_plain[output_count] = plain;
+                output_paths[output_count++] = optarg;
                 break;
             case 'c':
                 char_set = optarg;
@@ -55,7 +115,12 @@ int main(int argc, char* argv[]) {
                 }
                 break;
             case 'm':
-                if (strcmp(optarg, "16") == 0) {
+                // each -o takes the -m before it; the image is sampled once
+                // with the last color mode, `none` drops the colors of an output
+                plain = false;
+                if (strcmp(optarg, "none") == 0) {
+                    plain = true;
+                } else if (strcmp(optarg, "16") == 0) {
                     color = COLOR_16;
                 } else if (strcmp(optarg, "256") == 0) {
                     color = COLOR_256;
@@ -82,8 +147,112 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
                 break;
+            case 'G':
+                if (strcmp(optarg, "brightness") == 0) {
+                    glyph = GLYPH_BRIGHTNESS;
+                } else if (strcmp(optarg, "braille") == 0) {
+                    glyph = GLYPH_BRAILLE;
+                } else if (strcmp(optarg, "sextant") == 0) {
+                    glyph = GLYPH_SEXTANT;
+                } else if (strcmp(optarg, "shape") == 0) {
+                    glyph = GLYPH_SHAPE;
+                } else {
+                    printf("%s is not a valid glyph mode.\n", optarg); 
+                    return 1;
+                }
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    format = FORMAT_TEXT;
+                } else if (strcmp(optarg, "html") == 0) {
+                    format = FORMAT_HTML;
+                } else if (strcmp(optarg, "svg") == 0) {
+                    format = FORMAT_SVG;
+                } else if (strcmp(optarg, "png") == 0) {
+                    format = FORMAT_PNG;
+                } else {
+                    printf("%s is not a valid output format.\n", optarg); 
+                    return 1;
+                }
+                format_given = true;
+                break;
+            case 'W':
+                columns = atoi(optarg);
+                if (columns <= 0) {
+                    printf("%s is not a valid column count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'H':
+                rows = atoi(optarg);
+                if (rows <= 0) {
+                    printf("%s is not a valid row count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'X':
+                fixed_point = true;
+                break;
+            case 'l':
+                linear_light = true;
+                break;
+            case 'p':
+                if (strcmp(optarg, "block") == 0) {
+                    sampling = SAMPLING_BLOCK;
+                } else if (strcmp(optarg, "area") == 0) {
+                    sampling = SAMPLING_AREA;
+                } else if (strcmp(optarg, "triangle") == 0) {
+                    sampling = SAMPLING_TRIANGLE;
+                } else if (strcmp(optarg, "lanczos") == 0) {
+                    sampling = SAMPLING_LANCZOS;
+                } else {
+                    printf("%s is not a valid sampling mode.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'P':
+                layout = IMAGE_PLANAR;
+                break;
+            case 'x': {
+                char rest;
+                if (sscanf(optarg, "%d,%d,%d,%d%c", &crop.x, &crop.y, &crop.width, &crop.height, &rest) != 4 ||
+                    crop.x < 0 || crop.y < 0 || crop.width <= 0 || crop.height <= 0) {
+                    printf("%s is not a valid crop, expected x,y,width,height.\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'C':
+                cache_dir = optarg;
+                break;
+            case 'S':
+                cache_mb = strtoull(optarg, NULL, 10);
+                if (cache_mb == 0) {
+                    printf("%s is not a valid cache size.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'D':
+                serve_path = optarg;
+                break;
+            case 'T':
+                threads = atoi(optarg);
+                if (threads <= 0) {
+                    printf("%s is not a valid thread count.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'R':
+                remote_path = optarg;
+                break;
+            case 'B':
+                batch = true;
+                break;
+            case 's':
+                show_stats = true;
+                break;
             case 'h':
-                printf("Usage: %s [--input FILE] [--output FILE] [--charset SET] [--aspect RATIO] [--gray-method average|luminance] [--colored true|false] [--dither method] [--edge-detection method]\n", argv[0]);
+                printf("Usage: %s [--input FILE] [--output FILE] [--charset SET] [--aspect RATIO] [--gray-method average|luminance] [--colored 16|256|true|none] [--dither method] [--edge-detection method] [--glyph-mode brightness|braille|sextant|shape] [--format text|html|svg|png] [--columns N] [--rows N] [--fixed-point] [--linear] [--sampling block|area|triangle|lanczos] [--planar] [--crop X,Y,W,H] [--cache DIR] [--cache-size MB] [--serve SOCKET [--threads N]] [--remote SOCKET] [--batch [--threads N]] [--stats]\n", argv[0]);
                 return 0;
             default:
                 fprintf(stderr, "Try '%s -h' for help.\n", argv[0]);
@@ -91,11 +260,32 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (!input_path || !output_path) {
+    if (serve_path) {
+        RenderCache* cache = cache_dir ? Cache_open(cache_dir, cache_mb * 1024 * 1024) : NULL;
+        if (cache_dir && !cache) return 1;
+
+        ServerOptions options = {
+            .socket_path = serve_path,
+            .threads = threads,
+            .cache = cache,
+        };
+        bool served = Server_run(&options);
+
+        Cache_close(cache);
+        return served ? 0 : 1;
+    }
+
+    if (!input_path || output_count == 0) {
         fprintf(stderr, "Error: --input and --output are required.\n");
         return -1;
     }
 
+    // nothing to sample colors for when every output drops them
+    bool all_plain = true;
+    for (int i = 0; i < output_count; i++)
+        all_plain = all_plain && output_plain[i];
+    if (all_plain) color = COLOR_NONE;
+
     ASCIIGenConfig cfg = DEFAULT_CONFIG;
     cfg.char_set = char_set;
     cfg.terminal_aspect_ratio = aspect;
@@ -103,8 +293,89 @@ int main(int argc, char* argv[]) {
     cfg.color_mode = color;
     cfg.dither_mode = dither;
     cfg.edge_mode = edge;
+    cfg.glyph_mode = glyph;
+    cfg.columns = columns;
+    cfg.rows = rows;
+    cfg.fixed_point = fixed_point;
+    cfg.linear_light = linear_light;
+    cfg.sampling = sampling;
+    cfg.layout = layout;
+    cfg.crop = crop;
+
+    RenderStats stats;
+    Stats_reset(&stats);
+    if (show_stats) cfg.stats = &stats;
+
+    if (batch) {
+        // --input and --output name directories here
+        if (output_count != 1) {
+            fprintf(stderr, "Error: --batch takes exactly one output directory.\n");
+            return 1;
+        }
+        if (cache_dir) {
+            fprintf(stderr, "Error: --cache cannot be used with --batch.\n");
+            return 1;
+        }
+
+        cfg.output_format = format;
+        BatchOptions options = {
+            .input_dir = input_path,
+            .output_dir = output_paths[0],
+            .threads = threads,
+        };
+        bool rendered = Batch_run(&options, &cfg);
+
+        if (show_stats) Stats_print(&stats, stderr);
+        return rendered ? 0 : 1;
+    }
+
+    // every output gets its own format, the image is only processed once
+    OutputFormat formats[GENERATOR_MAX_SINKS];
+    for (int i = 0; i < output_count; i++)
+        formats[i] = format_given ? format : _formatFromPath(output_paths[i]);
+
+    // entries hold a single output, several outputs render in one pass; a
+    // remote render uses the server's cache
+    if (cache_dir && output_count > 1) {
+        fprintf(stderr, "Error: --cache takes a single --output.\n");
+        return 1;
+    }
+    if (cache_dir && remote_path) {
+        fprintf(stderr, "Error: --cache cannot be used with --remote, start the server with it.\n");
+        return 1;
+    }
+
+    RenderCache* cache = NULL;
+    if (cache_dir) {
+        cache = Cache_open(cache_dir, cache_mb * 1024 * 1024);
+        if (!cache) return 1;
+    }
+
+    // a single render spreads its tiles over --threads, one per CPU by default
+    cfg.threads = threads;
+
+    bool success;
+    if (remote_path) {
+        // one request per output, each answered from the server's shared state
+        success = true;
+        for (int i = 0; i < output_count && success; i++) {
+            cfg.output_format = formats[i];
+            cfg.color_mode = output_plain[i] ? COLOR_NONE : color;
+            success = Client_render(remote_path, input_path, output_paths[i], &cfg);
+        }
+    } else if (output_count == 1) {
+        cfg.output_format = formats[0];
+        success = Generator_generateCachedFromFile(input_path, output_paths[0], &cfg, cache);
+    } else {
+        success = Generator_generateMultiFromFile(input_path, output_paths, formats, output_plain, output_count, &cfg);
+    }
+
+    Cache_close(cache);
+
+    // remote renders happen in the server, there is nothing local to report
+    if (show_stats && !remote_path) Stats_print(&stats, stderr);
 
-    if (!Generator_generateACIIFromFile(input_path, output_path, &cfg)) {
+    if (!success) {
         fprintf(stderr, "Failed to generate ASCII art.\n");
         return 1;
     }